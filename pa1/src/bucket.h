@@ -0,0 +1,171 @@
+#ifndef BUCKET_H
+#define BUCKET_H
+
+#include <vector>
+#include <random>
+#include "cell.h"
+using namespace std;
+
+// selection policy of a run, picked once per refine
+enum BucketPolicy
+{
+    BUCKET_INDEX,   // the front two cells compared by their sorting index (default)
+    BUCKET_LIFO,
+    BUCKET_FIFO,
+    BUCKET_RANDOM,
+    BUCKET_CLIP
+};
+
+// selection policies of the gain bucket, fixed at compile time so the move loop inlines them:
+// INSERT_AT_TAIL tells where a cell enters its bucket, UPDATED_GAIN keys the buckets by the gain change
+// since the start of the pass (CLIP) instead of the gain, and pick chooses among the cells of the max bucket
+
+// newest cell first, the cell whose gain changed last
+struct LifoPolicy
+{
+    static const bool INSERT_AT_TAIL = false;
+    static const bool UPDATED_GAIN = false;
+    int pick(int head, const vector<Node>& /*nodeArray*/) { return head; }
+};
+
+// oldest cell first
+struct FifoPolicy
+{
+    static const bool INSERT_AT_TAIL = true;
+    static const bool UPDATED_GAIN = false;
+    int pick(int head, const vector<Node>& /*nodeArray*/) { return head; }
+};
+
+// a uniformly random cell among the first WINDOW of the bucket, so a pick stays O(1) on long buckets
+struct RandomPolicy
+{
+    static const bool INSERT_AT_TAIL = false;
+    static const bool UPDATED_GAIN = false;
+    static const int WINDOW = 8;
+    RandomPolicy(unsigned seed) : _rng(seed) { }
+    int pick(int head, const vector<Node>& nodeArray) {
+        int picked = head, seen = 1;
+        for (int cell = nodeArray[head].getNext(); cell != -1 && seen < WINDOW; cell = nodeArray[cell].getNext()) {
+            if (_rng() % ++seen == 0) {
+                picked = cell;
+            }
+        }
+        return picked;
+    }
+    mt19937 _rng;
+};
+
+// CLIP, every cell starts in the zero bucket ordered by its initial gain and moves by the updated gain,
+// newest first, so a pass keeps pulling in the neighbors of the cluster it started
+struct ClipPolicy
+{
+    static const bool INSERT_AT_TAIL = false;
+    static const bool UPDATED_GAIN = true;
+    int pick(int head, const vector<Node>& /*nodeArray*/) { return head; }
+};
+
+// the original tie-break, the front two cells of the bucket are compared by their sorting index
+struct SortingIndexPolicy
+{
+    static const bool INSERT_AT_TAIL = false;
+    static const bool UPDATED_GAIN = false;
+    SortingIndexPolicy(const vector<Cell>& cellArray) : _cellArray(&cellArray) { }
+    int pick(int head, const vector<Node>& nodeArray) {
+        int next = nodeArray[head].getNext();
+        return next != -1 && (*_cellArray)[head].getSortingIndex() <= (*_cellArray)[next].getSortingIndex() ? next : head;
+    }
+    const vector<Cell>* _cellArray;
+};
+
+// bucket list of both partitions, a doubly linked list of cell ids per key threaded through the nodes
+template <class Policy>
+class GainBucket
+{
+public:
+    // constructor and destructor
+    GainBucket(vector<Node>& nodeArray, const Policy& policy) :
+        _nodeArray(nodeArray), _policy(policy), _maxKey(0) {
+        _maxIdx[0] = -1;
+        _maxIdx[1] = -1;
+    }
+    ~GainBucket() { }
+
+    // basic access methods
+    // upper bound of the max non-empty key of a partition, comparable between the partitions
+    int getMaxIdx(int part) const   { return _maxIdx[part]; }
+
+    // empty every bucket, keys range in [-maxKey, maxKey]
+    void reset(int maxKey) {
+        _maxKey = maxKey;
+        for (int i = 0; i < 2; ++i) {
+            _head[i].assign(2 * maxKey + 1, -1);
+            if (Policy::INSERT_AT_TAIL) {
+                _tail[i].assign(2 * maxKey + 1, -1);
+            }
+            _maxIdx[i] = -1;
+        }
+    }
+
+    void insert(int cellId, int part, int key) {
+        Node& node = _nodeArray[cellId];
+        int idx = key + _maxKey;
+        if (Policy::INSERT_AT_TAIL && _tail[part][idx] != -1) {
+            node.setPrev(_tail[part][idx]);
+            _nodeArray[_tail[part][idx]].setNext(cellId);
+            _tail[part][idx] = cellId;
+        }
+        else {
+            int first = _head[part][idx];
+            if (first != -1) {
+                node.setNext(first);
+                _nodeArray[first].setPrev(cellId);
+            }
+            else if (Policy::INSERT_AT_TAIL) {
+                _tail[part][idx] = cellId;
+            }
+            _head[part][idx] = cellId;
+        }
+        // raise the max key pointer if needed
+        if (idx > _maxIdx[part]) {
+            _maxIdx[part] = idx;
+        }
+    }
+
+    // the max key pointer is lowered lazily
+    void remove(int cellId, int part, int key) {
+        Node& node = _nodeArray[cellId];
+        int prev = node.getPrev(), next = node.getNext();
+        if (prev != -1) {
+            _nodeArray[prev].setNext(next);
+        }
+        else {
+            _head[part][key + _maxKey] = next;
+        }
+        if (next != -1) {
+            _nodeArray[next].setPrev(prev);
+        }
+        else if (Policy::INSERT_AT_TAIL) {
+            _tail[part][key + _maxKey] = prev;
+        }
+        node.setPrev(-1);
+        node.setNext(-1);
+    }
+
+    // cell of the max non-empty bucket chosen by the policy, -1 if the partition has no free cell
+    int pick(int part) {
+        while (_maxIdx[part] >= 0 && _head[part][_maxIdx[part]] == -1) {
+            _maxIdx[part]--;
+        }
+        return _maxIdx[part] >= 0 ? _policy.pick(_head[part][_maxIdx[part]], _nodeArray) : -1;
+    }
+
+private:
+    vector<Node>&   _nodeArray;     // nodes of the partitioner, the links of the lists live in them
+    Policy          _policy;        // selection inside the max bucket
+    int             _maxKey;        // keys range in [-_maxKey, _maxKey], bucket of key k is k + _maxKey
+    vector<int>     _head[2];       // first cell of each bucket of partition A(0) and B(1), -1 if empty
+    vector<int>     _tail[2];       // last cell of each bucket, kept only by tail insertion
+    int             _maxIdx[2];     // upper bound of the max non-empty bucket of each partition
+};
+
+#endif  // BUCKET_H
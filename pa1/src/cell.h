@@ -1,55 +1,61 @@
 #ifndef CELL_H
 #define CELL_H
 
-#include <vector>
-#include <string>
+#include <cstddef>
 using namespace std;
 
+// hot state of a cell, the partitioner keeps one per cell in a contiguous array indexed by the cell id,
+// so the links are cell ids and the gain, part and lock of a cell share one 16-byte entry
 class Node
 {
-    friend class Cell;
-
 public:
     // Constructor and destructor
-    Node(const int& id) :
-        _id(id), _prev(NULL), _next(NULL) { }
+    Node() :
+        _gain(0), _prev(-1), _next(-1), _flags(0) { }
     ~Node() { }
 
     // Basic access methods
-    int getId() const       { return _id; }
-    Node* getPrev() const   { return _prev; }
-    Node* getNext() const   { return _next; }
+    int getGain() const     { return _gain; }
+    int getPrev() const     { return _prev; }
+    int getNext() const     { return _next; }
+    bool getPart() const    { return _flags & PART_BIT; }
+    bool isLocked() const   { return _flags & LOCK_BIT; }
 
     // Set functions
-    void setId(const int& id) { _id = id; }
-    void setPrev(Node* prev)  { _prev = prev; }
-    void setNext(Node* next)  { _next = next; }
+    void setGain(const int gain)    { _gain = gain; }
+    void setPrev(const int prev)    { _prev = prev; }
+    void setNext(const int next)    { _next = next; }
+    void addGain(const int delta)   { _gain += delta; }
+    void setPart(const bool part)   { _flags = part ? _flags | PART_BIT : _flags & ~PART_BIT; }
+    void setLock(const bool lock)   { _flags = lock ? _flags | LOCK_BIT : _flags & ~LOCK_BIT; }
+    // start of a pass, clear the gain, the links and the lock but keep the part
+    void reset() {
+        _gain = 0;
+        _prev = -1;
+        _next = -1;
+        _flags &= PART_BIT;
+    }
 
 private:
-    int         _id;    // id of the node (indicating the cell)
-    Node*       _prev;  // pointer to the previous node
-    Node*       _next;  // pointer to the next node
+    static const unsigned char PART_BIT = 1;
+    static const unsigned char LOCK_BIT = 2;
+
+    int             _gain;  // gain of the cell
+    int             _prev;  // id of the previous cell in the bucket, -1 at the head
+    int             _next;  // id of the next cell in the bucket, -1 at the tail
+    unsigned char   _flags; // partition (bit 0, 0-A, 1-B) and lock (bit 1) of the cell
 };
 
 class Cell
 {
 public:
     // Constructor and destructor
-    Cell(string& name, bool part, int id) :
-        _gain(0), _pinNum(0), _part(part), _lock(false), _name(name) {
-        _node = new Node(id);
-    }
+    Cell(const char* name) :
+        _name(name) { }
     ~Cell() { }
 
     // Basic access methods
-    int getGain() const     { return _gain; }
-    int getPinNum() const   { return _pinNum; }
-    bool getPart() const    { return _part; }
-    bool getLock() const    { return _lock; }
-    Node* getNode() const   { return _node; }
-    string getName() const  { return _name; }
-    int getFirstNet() const { return _netList[0]; }
-    vector<int> getNetList() const  { return _netList; }
+    const char* getName() const { return _name; }
     // added access methods
     int getMaxNetSize() const { return _maxNetSize; }
     int getAvgNetSize() const { return _avgNetSize; }
@@ -59,10 +65,7 @@ public:
     int getSortingIndex() const { return _sortingIndex; }
 
     // Set functions
-    void setNode(Node* node)        { _node = node; }
-    void setGain(const int gain)    { _gain = gain; }
-    void setPart(const bool part)   { _part = part; }
-    void setName(const string name) { _name = name; }
+    void setName(const char* name)  { _name = name; }
     // added set functions
     void setMaxNetSize(const int maxNetSize) { _maxNetSize = maxNetSize; }
     void setAvgNetSize(const int avgNetSize) { _avgNetSize = avgNetSize; }
@@ -70,24 +73,9 @@ public:
     void setBeta(const double beta)             { _beta = beta; }
     void setSortingIndex(const int sortingIndex) { _sortingIndex = sortingIndex; }
 
-    // Modify methods
-    void move()         { _part = !_part; }
-    void lock()         { _lock = true; }
-    void unlock()       { _lock = false; }
-    void incGain()      { ++_gain; }
-    void decGain()      { --_gain; }
-    void incPinNum()    { ++_pinNum; }
-    void decPinNum()    { --_pinNum; }
-    void addNet(const int netId) { _netList.push_back(netId); }
-
 private:
-    int             _gain;      // gain of the cell
-    int             _pinNum;    // number of pins the cell are connected to
-    bool            _part;      // partition the cell belongs to (0-A, 1-B)
-    bool            _lock;      // whether the cell is locked
-    Node*           _node;      // node used to link the cells together
-    string          _name;      // name of the cell
-    vector<int>     _netList;   // list of nets the cell is connected to
+    // gain, bucket links, part, lock and the net list live in the partitioner's flat arrays
+    const char*     _name;      // name of the cell, owned by the partitioner's name arena
     // added attributes
     int             _maxNetSize;
     int             _avgNetSize;
@@ -0,0 +1,420 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "nametable.h"
+#include "eco.h"
+using namespace std;
+
+void EcoPartitioner::readResult(vector<char> &cellKnown)
+{
+    // look the previous cells up by name, the ids of the table are the cell ids of the new netlist
+    NameTable cellNames;
+    for (int i = 0; i < (int)_cellPart.size(); ++i)
+    {
+        const char *name = _partitioner.getCellName(i);
+        bool inserted;
+        cellNames.intern(name, name + strlen(name), inserted);
+    }
+
+    ifstream resultFile(_resultName);
+    if (!resultFile)
+    {
+        cerr << "Cannot open the previous result \"" << _resultName
+             << "\". The program will be terminated..." << endl;
+        exit(1);
+    }
+    string token;
+    int part = -1;
+    while (resultFile >> token)
+    {
+        // "Cutsize = c", then "G1 size" and "G2 size" each followed by its cells and ";"
+        if (token == "G1" || token == "G2")
+        {
+            part = token == "G1" ? 0 : 1;
+            resultFile >> token;
+            continue;
+        }
+        if (token[0] == 'G' && part == -1 && token.size() > 1 && isdigit(token[1]))
+        {
+            cerr << "The previous result \"" << _resultName << "\" is not a bisection. The program will be terminated..." << endl;
+            exit(1);
+        }
+        if (token == ";")
+        {
+            part = -1;
+            continue;
+        }
+        if (part == -1)
+        {
+            continue;
+        }
+        int cellId = cellNames.find(token.data(), token.data() + token.size());
+        if (cellId == -1)
+        {
+            ++_missingCellNum;
+            continue;
+        }
+        if (!cellKnown[cellId])
+        {
+            ++_matchedCellNum;
+        }
+        _cellPart[cellId] = part;
+        cellKnown[cellId] = true;
+    }
+}
+
+void EcoPartitioner::placeNewCells(const vector<char> &cellKnown, vector<int> &region)
+{
+    // count the matched cells first, then put every new cell on the side its placed nets lean to
+    const Hypergraph &graph = _partitioner.getGraph();
+    double targetRatio = _partitioner.getTargetRatio();
+    for (int i = 0; i < graph.getCellNum(); ++i)
+    {
+        if (!cellKnown[i])
+        {
+            continue;
+        }
+        _partSize[(int)_cellPart[i]] += graph.getCellWeight(i);
+        for (const int *net = graph.cellNetBegin(i); net != graph.cellNetEnd(i); ++net)
+        {
+            _netPartCount[2 * *net + _cellPart[i]]++;
+        }
+    }
+    for (int i = 0; i < graph.getCellNum(); ++i)
+    {
+        if (cellKnown[i])
+        {
+            continue;
+        }
+        int score[2] = {0, 0};
+        for (const int *net = graph.cellNetBegin(i); net != graph.cellNetEnd(i); ++net)
+        {
+            for (int part = 0; part < 2; ++part)
+            {
+                if (_netPartCount[2 * *net + part] > 0)
+                {
+                    score[part] += graph.getNetWeight(*net);
+                }
+            }
+        }
+
+        // ties go to the side further below its target share, a side over its upper bound passes the cell on,
+        // and if neither side has room it goes where the least remains over the bound for rebalance to fix
+        int weight = graph.getCellWeight(i);
+        bool part = score[0] != score[1] ? score[1] > score[0] : _partSize[0] * (1 - targetRatio) > _partSize[1] * targetRatio;
+        if (_partSize[part] + weight > _upperBound[part])
+        {
+            if (_partSize[!part] + weight <= _upperBound[!part] ||
+                _partSize[!part] - _upperBound[!part] < _partSize[part] - _upperBound[part])
+            {
+                part = !part;
+            }
+        }
+        _cellPart[i] = part;
+        _partSize[part] += weight;
+        ++_newCellNum;
+        region.push_back(i);
+        for (const int *net = graph.cellNetBegin(i); net != graph.cellNetEnd(i); ++net)
+        {
+            _netPartCount[2 * *net + part]++;
+            if (graph.getNetSize(*net) > _largeNetSize)
+            {
+                continue;
+            }
+            for (const int *cell = graph.netCellBegin(*net); cell != graph.netCellEnd(*net); ++cell)
+            {
+                region.push_back(*cell);
+            }
+        }
+    }
+}
+
+int EcoPartitioner::computeGain(int cellId) const
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    int part = _cellPart[cellId], gain = 0;
+    for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+    {
+        if (_netPartCount[2 * *net + part] == 1)
+        {
+            gain += graph.getNetWeight(*net);
+        }
+        if (_netPartCount[2 * *net + !part] == 0)
+        {
+            gain -= graph.getNetWeight(*net);
+        }
+    }
+    return gain;
+}
+
+void EcoPartitioner::moveCell(int cellId)
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    int fromPart = _cellPart[cellId];
+    _cellPart[cellId] = !fromPart;
+    _partSize[fromPart] -= graph.getCellWeight(cellId);
+    _partSize[!fromPart] += graph.getCellWeight(cellId);
+    for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+    {
+        _netPartCount[2 * *net + fromPart]--;
+        _netPartCount[2 * *net + !fromPart]++;
+    }
+}
+
+void EcoPartitioner::rebalance(vector<int> &region)
+{
+    // removed cells may leave a side out of bounds, move the best cells off the heavy side
+    // starting from the region and growing over small nets, all cells of the side only if it runs dry
+    const Hypergraph &graph = _partitioner.getGraph();
+    for (int heavy = 0; heavy < 2; ++heavy)
+    {
+        if (_partSize[heavy] <= _upperBound[heavy] && _partSize[!heavy] >= _lowerBound[!heavy])
+        {
+            continue;
+        }
+        priority_queue<pair<int, int> > frontier;
+        for (size_t i = 0; i < region.size(); ++i)
+        {
+            if (_cellPart[region[i]] == heavy && !_cellQueued[region[i]])
+            {
+                _cellQueued[region[i]] = true;
+                _touchedCells.push_back(region[i]);
+                frontier.push(make_pair(this->computeGain(region[i]), -region[i]));
+            }
+        }
+        bool scanned = false;
+        while (_partSize[heavy] > _upperBound[heavy] || _partSize[!heavy] < _lowerBound[!heavy])
+        {
+            if (frontier.empty())
+            {
+                if (scanned)
+                {
+                    break;
+                }
+                scanned = true;
+                for (int i = 0; i < graph.getCellNum(); ++i)
+                {
+                    if (_cellPart[i] == heavy && !_cellQueued[i])
+                    {
+                        _cellQueued[i] = true;
+                        _touchedCells.push_back(i);
+                        frontier.push(make_pair(this->computeGain(i), -i));
+                    }
+                }
+                continue;
+            }
+            int cellId = -frontier.top().second, gain = frontier.top().first;
+            frontier.pop();
+            if (_cellPart[cellId] != heavy || _partSize[!heavy] + graph.getCellWeight(cellId) > _upperBound[!heavy])
+            {
+                continue;
+            }
+            int currentGain = this->computeGain(cellId);
+            if (currentGain != gain)
+            {
+                frontier.push(make_pair(currentGain, -cellId));
+                continue;
+            }
+            this->moveCell(cellId);
+            ++_moveNum;
+            region.push_back(cellId);
+            for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+            {
+                if (graph.getNetSize(*net) > _largeNetSize)
+                {
+                    continue;
+                }
+                for (const int *cell = graph.netCellBegin(*net); cell != graph.netCellEnd(*net); ++cell)
+                {
+                    if (_cellPart[*cell] == heavy)
+                    {
+                        if (!_cellQueued[*cell])
+                        {
+                            _cellQueued[*cell] = true;
+                            _touchedCells.push_back(*cell);
+                        }
+                        frontier.push(make_pair(this->computeGain(*cell), -*cell));
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < _touchedCells.size(); ++i)
+        {
+            _cellQueued[_touchedCells[i]] = false;
+        }
+        _touchedCells.clear();
+    }
+}
+
+int EcoPartitioner::refinePass(vector<int> &region)
+{
+    // F-M over a max heap of (gain, -cell id) which starts with the region and grows around every move,
+    // popped gains are checked against the current one, so stale entries only cost a recomputation
+    const Hypergraph &graph = _partitioner.getGraph();
+    priority_queue<pair<int, int> > frontier;
+    for (size_t i = 0; i < region.size(); ++i)
+    {
+        if (!_cellQueued[region[i]])
+        {
+            _cellQueued[region[i]] = true;
+            _touchedCells.push_back(region[i]);
+            frontier.push(make_pair(this->computeGain(region[i]), -region[i]));
+        }
+    }
+
+    int accGain = 0, bestGain = 0, bestMoveNum = 0;
+    _moveStack.clear();
+    while (!frontier.empty())
+    {
+        int cellId = -frontier.top().second, gain = frontier.top().first;
+        frontier.pop();
+        if (_cellLock[cellId])
+        {
+            continue;
+        }
+        int currentGain = this->computeGain(cellId);
+        if (currentGain != gain)
+        {
+            frontier.push(make_pair(currentGain, -cellId));
+            continue;
+        }
+        int part = _cellPart[cellId], weight = graph.getCellWeight(cellId);
+        if (_partSize[part] - weight < _lowerBound[part] || _partSize[!part] + weight > _upperBound[!part])
+        {
+            continue;
+        }
+
+        this->moveCell(cellId);
+        _cellLock[cellId] = true;
+        _moveStack.push_back(cellId);
+        accGain += gain;
+        if (accGain > bestGain)
+        {
+            bestGain = accGain;
+            bestMoveNum = _moveStack.size();
+        }
+        else if ((int)_moveStack.size() - bestMoveNum >= _searchWindow)
+        {
+            break;
+        }
+        for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+        {
+            if (graph.getNetSize(*net) > _largeNetSize)
+            {
+                continue;
+            }
+            for (const int *cell = graph.netCellBegin(*net); cell != graph.netCellEnd(*net); ++cell)
+            {
+                if (_cellLock[*cell])
+                {
+                    continue;
+                }
+                if (!_cellQueued[*cell])
+                {
+                    _cellQueued[*cell] = true;
+                    _touchedCells.push_back(*cell);
+                }
+                frontier.push(make_pair(this->computeGain(*cell), -*cell));
+            }
+        }
+    }
+
+    // back to the best prefix, the next pass starts around the kept moves
+    for (int i = _moveStack.size() - 1; i >= bestMoveNum; --i)
+    {
+        this->moveCell(_moveStack[i]);
+    }
+    region.clear();
+    for (int i = 0; i < bestMoveNum; ++i)
+    {
+        int cellId = _moveStack[i];
+        for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+        {
+            if (graph.getNetSize(*net) <= _largeNetSize)
+            {
+                region.insert(region.end(), graph.netCellBegin(*net), graph.netCellEnd(*net));
+            }
+        }
+    }
+    for (size_t i = 0; i < _moveStack.size(); ++i)
+    {
+        _cellLock[_moveStack[i]] = false;
+    }
+    for (size_t i = 0; i < _touchedCells.size(); ++i)
+    {
+        _cellQueued[_touchedCells[i]] = false;
+    }
+    _touchedCells.clear();
+    _moveNum += bestMoveNum;
+    return bestGain;
+}
+
+void EcoPartitioner::partition()
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    int cellNum = graph.getCellNum();
+    _cellPart.assign(cellNum, 0);
+    _netPartCount.assign(2 * graph.getNetNum(), 0);
+    _cellQueued.assign(cellNum, false);
+    _cellLock.assign(cellNum, false);
+    for (int i = 0; i < 2; ++i)
+    {
+        _partSize[i] = 0;
+        _lowerBound[i] = _partitioner.getLowerBound(i);
+        _upperBound[i] = _partitioner.getUpperBound(i);
+    }
+
+    // map the previous result and place the new cells around it
+    vector<char> cellKnown(cellNum, false);
+    vector<int> region;
+    this->readResult(cellKnown);
+    this->placeNewCells(cellKnown, region);
+
+    // a changed net shows up as a cell which gains by moving, one linear scan like the parse finds them
+    for (int i = 0; i < cellNum; ++i)
+    {
+        if (cellKnown[i] && this->computeGain(i) > 0)
+        {
+            region.push_back(i);
+        }
+    }
+    this->rebalance(region);
+    if (_partSize[0] < _lowerBound[0] || _partSize[0] > _upperBound[0] || _partSize[1] < _lowerBound[1] || _partSize[1] > _upperBound[1])
+    {
+        cerr << "Cannot balance the ECO partition (" << _partSize[0] << " / " << _partSize[1] << "), the result breaks the balance bounds." << endl;
+    }
+    sort(region.begin(), region.end());
+    region.erase(unique(region.begin(), region.end()), region.end());
+    _regionSize = region.size();
+
+    int cutSize = 0;
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        if (_netPartCount[2 * i] > 0 && _netPartCount[2 * i + 1] > 0)
+        {
+            cutSize += graph.getNetWeight(i);
+        }
+    }
+    cout << "ECO: " << _matchedCellNum << " cells matched, " << _newCellNum << " new, " << _missingCellNum << " removed, region of "
+         << _regionSize << " cells" << endl;
+    cout << "Initial cutsize: " << cutSize << endl;
+
+    // local passes until one brings no improvement
+    for (_passNum = 0; _passNum < _maxPassNum && !region.empty();)
+    {
+        ++_passNum;
+        if (this->refinePass(region) <= 0)
+        {
+            break;
+        }
+    }
+    cout << "ECO F-M: " << _moveNum << " moves in " << _passNum << " passes" << endl;
+    _partitioner.initPartition(_cellPart);
+}
@@ -0,0 +1,66 @@
+#ifndef ECO_H
+#define ECO_H
+
+#include <vector>
+#include "hypergraph.h"
+#include "partitioner.h"
+using namespace std;
+
+// incremental repartitioning after a small netlist change, the previous result is mapped by cell name,
+// new cells are placed greedily and F-M only runs on the region around the change
+class EcoPartitioner
+{
+public:
+    // constructor and destructor, resultName is a bisection written by writeResult for the old netlist
+    EcoPartitioner(Partitioner& partitioner, const char* resultName) :
+        _partitioner(partitioner), _resultName(resultName), _largeNetSize(50), _searchWindow(100), _maxPassNum(8),
+        _matchedCellNum(0), _newCellNum(0), _missingCellNum(0), _regionSize(0), _passNum(0), _moveNum(0) { }
+    ~EcoPartitioner() { }
+
+    // basic access methods
+    int getMatchedCellNum() const   { return _matchedCellNum; }
+    int getNewCellNum() const       { return _newCellNum; }
+    int getMissingCellNum() const   { return _missingCellNum; }
+    int getRegionSize() const       { return _regionSize; }
+    int getPassNum() const          { return _passNum; }
+    int getMoveNum() const          { return _moveNum; }
+
+    // set functions
+    void setMaxPassNum(const int maxPassNum)    { _maxPassNum = maxPassNum; }
+
+    // modify method
+    void partition();
+
+private:
+    Partitioner&        _partitioner;       // partitioner of the new netlist, receives the final partition
+    const char*         _resultName;        // previous result file
+    int                 _largeNetSize;      // the region does not grow over nets larger than this
+    int                 _searchWindow;      // a pass stops after this many moves without a new best prefix
+    int                 _maxPassNum;        // upper bound of the local F-M passes
+    int                 _matchedCellNum;    // cells of the new netlist found in the previous result
+    int                 _newCellNum;        // cells of the new netlist missing from the previous result
+    int                 _missingCellNum;    // cells of the previous result missing from the new netlist
+    int                 _regionSize;        // cells the local passes started from
+    int                 _passNum;           // number of local F-M passes run
+    int                 _moveNum;           // number of kept moves over all passes
+    vector<char>        _cellPart;          // partition of each cell (0-A, 1-B)
+    vector<int>         _netPartCount;      // cell number of each net in A(2 * id) and B(2 * id + 1)
+    int                 _partSize[2];       // size (cell weight) of partition A(0) and B(1)
+    double              _lowerBound[2];     // lower bound of the size of each partition
+    double              _upperBound[2];     // upper bound of the size of each partition
+
+    // local pass state, reset through the touched list so a pass costs only what it touched
+    vector<char>        _cellQueued;        // whether each cell was queued in this pass
+    vector<char>        _cellLock;          // whether each cell has moved in this pass
+    vector<int>         _touchedCells;      // cells queued in this pass
+    vector<int>         _moveStack;         // cells moved in this pass
+
+    void readResult(vector<char>& cellKnown);
+    void placeNewCells(const vector<char>& cellKnown, vector<int>& region);
+    void rebalance(vector<int>& region);
+    int computeGain(int cellId) const;
+    void moveCell(int cellId);
+    int refinePass(vector<int>& region);
+};
+
+#endif  // ECO_H
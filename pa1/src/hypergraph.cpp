@@ -0,0 +1,135 @@
+#include <vector>
+#include <ostream>
+#include <cstring>
+#include "hypergraph.h"
+using namespace std;
+
+void Hypergraph::buildCellNets()
+{
+    // count the degree of each cell
+    _cellNetStart.assign(_cellNum + 1, 0);
+    for (size_t i = 0, end = _netCells.size(); i < end; ++i)
+    {
+        ++_cellNetStart[_netCells[i] + 1];
+    }
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        _cellNetStart[i + 1] += _cellNetStart[i];
+    }
+
+    // scatter the nets in id order, so the nets of a cell stay sorted
+    _cellNets.resize(_netCells.size());
+    vector<int> fillPos(_cellNetStart.begin(), _cellNetStart.end() - 1);
+    for (int i = 0; i < _netNum; ++i)
+    {
+        for (int j = _netCellStart[i]; j < _netCellStart[i + 1]; ++j)
+        {
+            _cellNets[fillPos[_netCells[j]]++] = i;
+        }
+    }
+    return;
+}
+
+bool Hypergraph::build(int cellNum, const vector<int> &netStart, const vector<int> &netCells,
+                       const vector<int> &cellWeight, const vector<int> &netWeight)
+{
+    // check the arrays first, so a bad call leaves nothing half built
+    int netNum = netStart.empty() ? 0 : netStart.size() - 1;
+    bool valid = cellNum >= 0 && (netStart.empty() ? netCells.empty() : netStart[0] == 0 && netStart[netNum] == (int)netCells.size()) &&
+                 (cellWeight.empty() || (int)cellWeight.size() == cellNum) && (netWeight.empty() || (int)netWeight.size() == netNum);
+    for (int i = 0; valid && i < netNum; ++i)
+    {
+        valid = netStart[i] <= netStart[i + 1] && (netWeight.empty() || netWeight[i] >= 1);
+    }
+    for (size_t i = 0; valid && i < cellWeight.size(); ++i)
+    {
+        valid = cellWeight[i] >= 1;
+    }
+    // the gains count a net once per pin, so a cell may appear only once in a net
+    vector<int> lastNet(valid ? cellNum : 0, -1);
+    for (int i = 0; valid && i < netNum; ++i)
+    {
+        for (int j = netStart[i]; valid && j < netStart[i + 1]; ++j)
+        {
+            int cellId = netCells[j];
+            valid = cellId >= 0 && cellId < cellNum && lastNet[cellId] != i;
+            if (valid)
+            {
+                lastNet[cellId] = i;
+            }
+        }
+    }
+    this->clear();
+    if (!valid)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < cellNum; ++i)
+    {
+        this->addCell(cellWeight.empty() ? 1 : cellWeight[i]);
+    }
+    if (netNum > 0)
+    {
+        _netCellStart = netStart;
+    }
+    _netCells = netCells;
+    _netWeight = netWeight.empty() ? vector<int>(netNum, 1) : netWeight;
+    _netNum = netNum;
+    this->buildCellNets();
+    return true;
+}
+
+void Hypergraph::writeBinary(ostream &out) const
+{
+    int pinNum = _netCells.size();
+    out.write((const char *)&pinNum, sizeof(int));
+    out.write((const char *)_netCellStart.data(), sizeof(int) * _netCellStart.size());
+    out.write((const char *)_netCells.data(), sizeof(int) * _netCells.size());
+    out.write((const char *)_cellWeight.data(), sizeof(int) * _cellWeight.size());
+    out.write((const char *)_netWeight.data(), sizeof(int) * _netWeight.size());
+    return;
+}
+
+// copy one int array out of a snapshot and advance the read pointer
+static const char *readArray(const char *data, vector<int> &array, size_t size)
+{
+    array.resize(size);
+    memcpy(array.data(), data, sizeof(int) * size);
+    return data + sizeof(int) * size;
+}
+
+const char *Hypergraph::readBinary(const char *data, int cellNum, int netNum)
+{
+    // the caller has checked the payload against the snapshot header and checksum
+    int pinNum;
+    memcpy(&pinNum, data, sizeof(int));
+    _cellNum = cellNum;
+    _netNum = netNum;
+    data += sizeof(int);
+    data = readArray(data, _netCellStart, netNum + 1);
+    data = readArray(data, _netCells, pinNum);
+    data = readArray(data, _cellWeight, cellNum);
+    data = readArray(data, _netWeight, netNum);
+    _totalCellWeight = 0;
+    for (int i = 0; i < cellNum; ++i)
+    {
+        _totalCellWeight += _cellWeight[i];
+    }
+    buildCellNets();
+    return data;
+}
+
+void Hypergraph::clear()
+{
+    _cellNum = 0;
+    _netNum = 0;
+    _totalCellWeight = 0;
+    _netCellStart.assign(1, 0);
+    _netCells.clear();
+    _cellNetStart.clear();
+    _cellNets.clear();
+    _cellWeight.clear();
+    _netWeight.clear();
+    return;
+}
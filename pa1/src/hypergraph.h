@@ -0,0 +1,71 @@
+#ifndef HYPERGRAPH_H
+#define HYPERGRAPH_H
+
+#include <vector>
+#include <ostream>
+using namespace std;
+
+class Hypergraph
+{
+public:
+    // constructor and destructor
+    Hypergraph() :
+        _cellNum(0), _netNum(0), _totalCellWeight(0) {
+        _netCellStart.push_back(0);
+    }
+    ~Hypergraph() { }
+
+    // basic access methods
+    int getCellNum() const              { return _cellNum; }
+    int getNetNum() const               { return _netNum; }
+    int getPinNum() const               { return (int)_netCells.size(); }
+    int getNetSize(int netId) const     { return _netCellStart[netId + 1] - _netCellStart[netId]; }
+    int getCellDegree(int cellId) const { return _cellNetStart[cellId + 1] - _cellNetStart[cellId]; }
+    int getCellWeight(int cellId) const { return _cellWeight[cellId]; }
+    int getNetWeight(int netId) const   { return _netWeight[netId]; }
+    int getTotalCellWeight() const      { return _totalCellWeight; }
+
+    // adjacency ranges, [begin, end) of the cells on a net or the nets on a cell
+    const int* netCellBegin(int netId) const    { return _netCells.data() + _netCellStart[netId]; }
+    const int* netCellEnd(int netId) const      { return _netCells.data() + _netCellStart[netId + 1]; }
+    const int* cellNetBegin(int cellId) const   { return _cellNets.data() + _cellNetStart[cellId]; }
+    const int* cellNetEnd(int cellId) const     { return _cellNets.data() + _cellNetStart[cellId + 1]; }
+
+    // build methods, nets are appended pin by pin and closed in id order
+    int addCell(const int weight = 1) {
+        _cellWeight.push_back(weight);
+        _totalCellWeight += weight;
+        return _cellNum++;
+    }
+    void addPin(const int cellId)   { _netCells.push_back(cellId); }
+    int closeNet(const int weight = 1) {
+        _netCellStart.push_back((int)_netCells.size());
+        _netWeight.push_back(weight);
+        return _netNum++;
+    }
+    void buildCellNets();
+    // build from arrays in one call, net i holds netCells[netStart[i]] .. netCells[netStart[i + 1] - 1],
+    // empty weight arrays mean unit weights, returns false (leaving the graph empty) on inconsistent arrays,
+    // a weight below 1 or a cell given twice in one net
+    bool build(int cellNum, const vector<int>& netStart, const vector<int>& netCells,
+               const vector<int>& cellWeight = vector<int>(), const vector<int>& netWeight = vector<int>());
+
+    // raw array (de)serialization for netlist snapshots
+    void writeBinary(ostream& out) const;
+    const char* readBinary(const char* data, int cellNum, int netNum);
+
+    void clear();
+
+private:
+    int             _cellNum;       // number of cells
+    int             _netNum;        // number of nets
+    int             _totalCellWeight;   // sum of all cell weights
+    vector<int>     _netCellStart;  // offset of each net in _netCells (netNum + 1 entries)
+    vector<int>     _netCells;      // cells of all nets, net by net
+    vector<int>     _cellNetStart;  // offset of each cell in _cellNets (cellNum + 1 entries)
+    vector<int>     _cellNets;      // nets of all cells, cell by cell
+    vector<int>     _cellWeight;    // weight of each cell (1 unless coarsened)
+    vector<int>     _netWeight;     // weight of each net (1 unless merged)
+};
+
+#endif  // HYPERGRAPH_H
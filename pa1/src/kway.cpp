@@ -0,0 +1,226 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <memory>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "multilevel.h"
+#include "threadpool.h"
+#include "kwayrefiner.h"
+#include "kway.h"
+using namespace std;
+
+void KWayPartitioner::extract(const Hypergraph &graph, const vector<int> &cellIds, const Partitioner &bisection, int part,
+                              Hypergraph &sub, vector<int> &subCellIds) const
+{
+    // renumber the cells of one side
+    vector<int> subId(graph.getCellNum(), -1);
+    for (int i = 0; i < graph.getCellNum(); ++i)
+    {
+        if (bisection.getCellPart(i) == part)
+        {
+            subId[i] = sub.addCell(graph.getCellWeight(i));
+            subCellIds.push_back(cellIds[i]);
+        }
+    }
+
+    // a cut net is split, its pins on this side stay connected so later bisections
+    // keep pulling them together, nets left with a single pin can no longer be cut
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        int pinNum = 0;
+        for (const int *cell = graph.netCellBegin(i); cell != graph.netCellEnd(i); ++cell)
+        {
+            if (subId[*cell] != -1)
+            {
+                ++pinNum;
+            }
+        }
+        if (pinNum < 2)
+        {
+            continue;
+        }
+        for (const int *cell = graph.netCellBegin(i); cell != graph.netCellEnd(i); ++cell)
+        {
+            if (subId[*cell] != -1)
+            {
+                sub.addPin(subId[*cell]);
+            }
+        }
+        sub.closeNet(graph.getNetWeight(i));
+    }
+    sub.buildCellNets();
+}
+
+void KWayPartitioner::bisect(ThreadPool &pool, shared_ptr<const Hypergraph> graph, shared_ptr<vector<int> > cellIds, int blockNum, int firstBlock)
+{
+    // a sub-hypergraph and its cell ids live as long as the tasks holding them, so a throwing task leaks nothing
+    if (blockNum == 1)
+    {
+        for (size_t i = 0; i < cellIds->size(); ++i)
+        {
+            _cellBlock[(*cellIds)[i]] = firstBlock;
+        }
+    }
+    else
+    {
+        // A receives floor(k/2) blocks, so its share of the weight follows the block count
+        int blockNum0 = blockNum / 2;
+        shared_ptr<Hypergraph> sub[2] = {make_shared<Hypergraph>(), make_shared<Hypergraph>()};
+        shared_ptr<vector<int> > subCellIds[2] = {make_shared<vector<int> >(), make_shared<vector<int> >()};
+        {
+            Partitioner bisection(*graph, _levelBFactor);
+            bisection.setTargetRatio((double)blockNum0 / blockNum);
+            bisection.setStopPolicy(_partitioner.getStopPolicy());
+            bisection.setBucketPolicy(_partitioner.getBucketPolicy());
+            bisection.setLargeNetSize(_partitioner.getLargeNetSize());
+            if (_multilevel)
+            {
+                MultilevelPartitioner multilevelPartitioner(bisection);
+                multilevelPartitioner.setVerbose(false);
+                multilevelPartitioner.partition();
+            }
+            else
+            {
+                bisection.initPartition();
+                bisection.refine();
+            }
+            for (int i = 0; i < 2; ++i)
+            {
+                this->extract(*graph, *cellIds, bisection, i, *sub[i], *subCellIds[i]);
+            }
+        }
+
+        // the two halves are independent, each one becomes a task of its own
+        int subBlockNum[2] = {blockNum0, blockNum - blockNum0};
+        int subFirstBlock[2] = {firstBlock, firstBlock + blockNum0};
+        for (int i = 0; i < 2; ++i)
+        {
+            shared_ptr<const Hypergraph> subGraph = sub[i];
+            shared_ptr<vector<int> > subIds = subCellIds[i];
+            int num = subBlockNum[i], first = subFirstBlock[i];
+            pool.submit([this, &pool, subGraph, subIds, num, first]
+                        { this->bisect(pool, subGraph, subIds, num, first); });
+        }
+    }
+}
+
+void KWayPartitioner::partition()
+{
+    const Hypergraph &finest = _partitioner.getGraph();
+
+    // block weight <= (1 + b) * W / k, met when every level of the recursion keeps (1 + b') per bisection
+    int depth = 0;
+    while ((1 << depth) < _blockNum)
+    {
+        ++depth;
+    }
+    _levelBFactor = pow(1 + _partitioner.getBFactor(), 1.0 / max(1, depth)) - 1;
+
+    _cellBlock.assign(finest.getCellNum(), 0);
+    // the finest graph belongs to _partitioner, so its pointer does not delete it
+    shared_ptr<const Hypergraph> graph(&finest, [](const Hypergraph *) {});
+    shared_ptr<vector<int> > cellIds = make_shared<vector<int> >(finest.getCellNum());
+    for (int i = 0; i < finest.getCellNum(); ++i)
+    {
+        (*cellIds)[i] = i;
+    }
+    {
+        ThreadPool pool(_threadNum);
+        pool.submit([this, &pool, graph, cellIds]
+                    { this->bisect(pool, graph, cellIds, _blockNum, 0); });
+        pool.wait();
+    }
+    this->computeCut();
+    cout << "Recursive bisection cutsize: " << _cutSize << " (connectivity " << _connectivity << ")" << endl;
+
+    // polish the whole k-way solution with direct k-way moves
+    KWayRefiner refiner(finest, _blockNum, _partitioner.getBFactor(), _cellBlock);
+    refiner.setStopPolicy(_partitioner.getStopPolicy());
+    refiner.refine();
+    cout << "K-way FM: " << refiner.getMoveNum() << " moves in " << refiner.getPassNum() << " passes (kept/tried:";
+    for (int i = 0; i < refiner.getPassNum(); ++i)
+    {
+        cout << " " << refiner.getPassKeptNum(i) << "/" << refiner.getPassMoveNum(i);
+    }
+    cout << ")" << endl;
+    this->computeCut();
+}
+
+void KWayPartitioner::computeCut()
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    _blockSize.assign(_blockNum, 0);
+    for (int i = 0; i < graph.getCellNum(); ++i)
+    {
+        _blockSize[_cellBlock[i]] += graph.getCellWeight(i);
+    }
+
+    _cutSize = 0;
+    _connectivity = 0;
+    vector<int> seen(_blockNum, -1);
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        int lambda = 0;
+        for (const int *cell = graph.netCellBegin(i); cell != graph.netCellEnd(i); ++cell)
+        {
+            if (seen[_cellBlock[*cell]] != i)
+            {
+                seen[_cellBlock[*cell]] = i;
+                ++lambda;
+            }
+        }
+        if (lambda > 1)
+        {
+            _cutSize += graph.getNetWeight(i);
+            _connectivity += (lambda - 1) * graph.getNetWeight(i);
+        }
+    }
+}
+
+void KWayPartitioner::printSummary() const
+{
+    cout << endl;
+    cout << "==================== Summary ====================" << endl;
+    cout << " Cutsize: " << _cutSize << endl;
+    cout << " Connectivity (lambda - 1): " << _connectivity << endl;
+    cout << " Total cell number: " << _partitioner.getCellNum() << endl;
+    cout << " Total net number:  " << _partitioner.getNetNum() << endl;
+    cout << " Block number: " << _blockNum << endl;
+    for (int i = 0; i < _blockNum; ++i)
+    {
+        cout << " Cell Number of block G" << i + 1 << ": " << _blockSize[i] << endl;
+    }
+    cout << "=================================================" << endl;
+    cout << endl;
+    return;
+}
+
+void KWayPartitioner::writeResult(fstream &outFile)
+{
+    // same layout as the 2-way result, one group per block
+    vector<vector<int> > blockCells(_blockNum);
+    for (int i = 0; i < _partitioner.getCellNum(); ++i)
+    {
+        blockCells[_cellBlock[i]].push_back(i);
+    }
+
+    stringstream buff;
+    buff << _cutSize;
+    outFile << "Cutsize = " << buff.str() << '\n';
+    for (int i = 0; i < _blockNum; ++i)
+    {
+        buff.str("");
+        buff << _blockSize[i];
+        outFile << "G" << i + 1 << " " << buff.str() << '\n';
+        for (size_t j = 0; j < blockCells[i].size(); ++j)
+        {
+            outFile << _partitioner.getCellName(blockCells[i][j]) << " ";
+        }
+        outFile << ";\n";
+    }
+    return;
+}
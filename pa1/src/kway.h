@@ -0,0 +1,56 @@
+#ifndef KWAY_H
+#define KWAY_H
+
+#include <fstream>
+#include <vector>
+#include <memory>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "threadpool.h"
+using namespace std;
+
+class KWayPartitioner
+{
+public:
+    // constructor and destructor, threadNum <= 0 means one thread per hardware thread
+    KWayPartitioner(Partitioner& partitioner, int blockNum, int threadNum) :
+        _partitioner(partitioner), _blockNum(blockNum), _threadNum(threadNum), _multilevel(false),
+        _levelBFactor(0), _cutSize(0), _connectivity(0) { }
+    ~KWayPartitioner() { }
+
+    // basic access methods
+    int getBlockNum() const             { return _blockNum; }
+    int getCutSize() const              { return _cutSize; }
+    int getConnectivity() const         { return _connectivity; }
+    int getBlockSize(int block) const   { return _blockSize[block]; }
+    int getCellBlock(int cellId) const  { return _cellBlock[cellId]; }
+
+    // set functions
+    void setMultilevel(const bool multilevel)   { _multilevel = multilevel; }
+
+    // modify method
+    void partition();
+
+    // member functions about reporting
+    void printSummary() const;
+    void writeResult(fstream& outFile);
+
+private:
+    Partitioner&        _partitioner;   // partitioner which holds the netlist and the cell names
+    int                 _blockNum;      // number of blocks k
+    int                 _threadNum;     // number of worker threads
+    bool                _multilevel;    // whether each bisection runs the multilevel flow
+    double              _levelBFactor;  // balance factor of a single bisection
+    int                 _cutSize;       // number (weight) of nets spanning more than one block
+    int                 _connectivity;  // sum of (lambda - 1) * weight, lambda is the number of blocks a net spans
+    vector<int>         _cellBlock;     // block of each cell
+    vector<int>         _blockSize;     // size (cell weight) of each block
+
+    // split the cells of graph into blockNum blocks starting at firstBlock, the halves become new tasks
+    void bisect(ThreadPool& pool, shared_ptr<const Hypergraph> graph, shared_ptr<vector<int> > cellIds, int blockNum, int firstBlock);
+    void extract(const Hypergraph& graph, const vector<int>& cellIds, const Partitioner& bisection, int part,
+                 Hypergraph& sub, vector<int>& subCellIds) const;
+    void computeCut();
+};
+
+#endif  // KWAY_H
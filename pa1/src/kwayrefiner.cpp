@@ -0,0 +1,380 @@
+#include <vector>
+#include <algorithm>
+#include "hypergraph.h"
+#include "kwayrefiner.h"
+using namespace std;
+
+KWayRefiner::KWayRefiner(const Hypergraph &graph, int blockNum, double bFactor, vector<int> &cellBlock) :
+    _graph(graph), _blockNum(blockNum), _maxBlockSize((1 + bFactor) * graph.getTotalCellWeight() / blockNum),
+    _cellBlock(cellBlock), _cutSize(0), _connectivity(0), _maxPinNum(0), _passNum(0), _moveNum(0),
+    _stopPolicy(new FixedFractionStop())
+{
+    _cellNetWeight.assign(_graph.getCellNum(), 0);
+    for (int i = 0; i < _graph.getCellNum(); ++i)
+    {
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
+        {
+            _cellNetWeight[i] += _graph.getNetWeight(*net);
+        }
+        _maxPinNum = max(_maxPinNum, _cellNetWeight[i]);
+    }
+    this->initCounts();
+}
+
+void KWayRefiner::initCounts()
+{
+    _blockSize.assign(_blockNum, 0);
+    for (int i = 0; i < _graph.getCellNum(); ++i)
+    {
+        _blockSize[_cellBlock[i]] += _graph.getCellWeight(i);
+    }
+
+    _netBlockCount.assign((size_t)_graph.getNetNum() * _blockNum, 0);
+    _netLambda.assign(_graph.getNetNum(), 0);
+    _cutSize = 0;
+    _connectivity = 0;
+    for (int i = 0; i < _graph.getNetNum(); ++i)
+    {
+        int *count = &_netBlockCount[(size_t)i * _blockNum];
+        for (const int *cell = _graph.netCellBegin(i); cell != _graph.netCellEnd(i); ++cell)
+        {
+            if (count[_cellBlock[*cell]]++ == 0)
+            {
+                ++_netLambda[i];
+            }
+        }
+        if (_netLambda[i] > 1)
+        {
+            _cutSize += _graph.getNetWeight(i);
+            _connectivity += (_netLambda[i] - 1) * _graph.getNetWeight(i);
+        }
+    }
+}
+
+int KWayRefiner::computeGain(int cellId, int block) const
+{
+    // moving to block saves the nets the cell is alone on and pays for the nets block does not reach yet
+    int penalty = _cellNetWeight[cellId];
+    for (const int *net = _graph.cellNetBegin(cellId); net != _graph.cellNetEnd(cellId); ++net)
+    {
+        if (_netBlockCount[(size_t)*net * _blockNum + block] > 0)
+        {
+            penalty -= _graph.getNetWeight(*net);
+        }
+    }
+    return _benefit[cellId] - penalty;
+}
+
+int KWayRefiner::findEntry(int cellId, int block) const
+{
+    const vector<int> &entries = _cellEntries[cellId];
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (_entryBlock[entries[i]] == block)
+        {
+            return entries[i];
+        }
+    }
+    return -1;
+}
+
+void KWayRefiner::addEntry(int cellId, int block, int gain)
+{
+    int entry = _entryCell.size();
+    _entryCell.push_back(cellId);
+    _entryBlock.push_back(block);
+    _entryGain.push_back(gain);
+    _entryPrev.push_back(-1);
+    _entryNext.push_back(-1);
+    _cellEntries[cellId].push_back(entry);
+    this->insertEntry(entry);
+}
+
+void KWayRefiner::insertEntry(int entry)
+{
+    int bucket = _entryGain[entry] + _maxPinNum;
+    int &head = _bucketHead[(size_t)_entryBlock[entry] * (2 * _maxPinNum + 1) + bucket];
+    _entryPrev[entry] = -1;
+    _entryNext[entry] = head;
+    if (head != -1)
+    {
+        _entryPrev[head] = entry;
+    }
+    head = entry;
+    _maxGainIdx[_entryBlock[entry]] = max(_maxGainIdx[_entryBlock[entry]], bucket);
+}
+
+void KWayRefiner::removeEntry(int entry)
+{
+    if (_entryPrev[entry] != -1)
+    {
+        _entryNext[_entryPrev[entry]] = _entryNext[entry];
+    }
+    else
+    {
+        _bucketHead[(size_t)_entryBlock[entry] * (2 * _maxPinNum + 1) + _entryGain[entry] + _maxPinNum] = _entryNext[entry];
+    }
+    if (_entryNext[entry] != -1)
+    {
+        _entryPrev[_entryNext[entry]] = _entryPrev[entry];
+    }
+}
+
+void KWayRefiner::updateEntry(int entry, int delta)
+{
+    this->removeEntry(entry);
+    _entryGain[entry] += delta;
+    this->insertEntry(entry);
+}
+
+void KWayRefiner::updateCellEntries(int cellId, int delta)
+{
+    // a change of the benefit shifts the gain towards every target block
+    _benefit[cellId] += delta;
+    const vector<int> &entries = _cellEntries[cellId];
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        this->updateEntry(entries[i], delta);
+    }
+}
+
+void KWayRefiner::initGain()
+{
+    int cellNum = _graph.getCellNum();
+    _cellLock.assign(cellNum, false);
+    _benefit.assign(cellNum, 0);
+    _cellEntries.assign(cellNum, vector<int>());
+    _entryCell.clear();
+    _entryBlock.clear();
+    _entryGain.clear();
+    _entryPrev.clear();
+    _entryNext.clear();
+    _bucketHead.assign((size_t)_blockNum * (2 * _maxPinNum + 1), -1);
+    _maxGainIdx.assign(_blockNum, -1);
+
+    for (int i = 0; i < cellNum; ++i)
+    {
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
+        {
+            if (_netBlockCount[(size_t)*net * _blockNum + _cellBlock[i]] == 1)
+            {
+                _benefit[i] += _graph.getNetWeight(*net);
+            }
+        }
+    }
+
+    // only the blocks a cell is connected to are worth an entry, their gains come from one scan of the nets
+    vector<int> connWeight(_blockNum, 0), netSeen(_blockNum, -1), touched;
+    int stamp = 0;
+    for (int i = 0; i < cellNum; ++i)
+    {
+        touched.clear();
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
+        {
+            if (_netLambda[*net] < 2)
+            {
+                continue;
+            }
+            int netWeight = _graph.getNetWeight(*net);
+            ++stamp;
+            if (_graph.getNetSize(*net) <= _blockNum)
+            {
+                for (const int *cell = _graph.netCellBegin(*net); cell != _graph.netCellEnd(*net); ++cell)
+                {
+                    int block = _cellBlock[*cell];
+                    if (netSeen[block] != stamp && block != _cellBlock[i])
+                    {
+                        netSeen[block] = stamp;
+                        if (connWeight[block] == 0)
+                        {
+                            touched.push_back(block);
+                        }
+                        connWeight[block] += netWeight;
+                    }
+                }
+            }
+            else
+            {
+                const int *count = &_netBlockCount[(size_t)*net * _blockNum];
+                for (int block = 0; block < _blockNum; ++block)
+                {
+                    if (count[block] > 0 && block != _cellBlock[i])
+                    {
+                        if (connWeight[block] == 0)
+                        {
+                            touched.push_back(block);
+                        }
+                        connWeight[block] += netWeight;
+                    }
+                }
+            }
+        }
+        for (size_t j = 0; j < touched.size(); ++j)
+        {
+            this->addEntry(i, touched[j], _benefit[i] - (_cellNetWeight[i] - connWeight[touched[j]]));
+            connWeight[touched[j]] = 0;
+        }
+    }
+}
+
+bool KWayRefiner::pickMove(int &entry)
+{
+    // best head over all target blocks, a target whose head does not fit is full for now
+    entry = -1;
+    for (int block = 0; block < _blockNum; ++block)
+    {
+        const int *head = &_bucketHead[(size_t)block * (2 * _maxPinNum + 1)];
+        while (_maxGainIdx[block] >= 0 && head[_maxGainIdx[block]] == -1)
+        {
+            --_maxGainIdx[block];
+        }
+        if (_maxGainIdx[block] < 0)
+        {
+            continue;
+        }
+        int candidate = head[_maxGainIdx[block]];
+        if (_blockSize[block] + _graph.getCellWeight(_entryCell[candidate]) > _maxBlockSize)
+        {
+            continue;
+        }
+        if (entry == -1 || _entryGain[candidate] > _entryGain[entry] ||
+            (_entryGain[candidate] == _entryGain[entry] && _blockSize[block] < _blockSize[_entryBlock[entry]]))
+        {
+            entry = candidate;
+        }
+    }
+    return entry != -1;
+}
+
+void KWayRefiner::moveCell(int cellId, int toBlock, bool updateGain)
+{
+    int fromBlock = _cellBlock[cellId], weight = _graph.getCellWeight(cellId);
+    _cellBlock[cellId] = toBlock;
+    _blockSize[fromBlock] -= weight;
+    _blockSize[toBlock] += weight;
+    if (updateGain)
+    {
+        _cellLock[cellId] = true;
+        const vector<int> &entries = _cellEntries[cellId];
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            this->removeEntry(entries[i]);
+        }
+        _cellEntries[cellId].clear();
+    }
+
+    for (const int *net = _graph.cellNetBegin(cellId); net != _graph.cellNetEnd(cellId); ++net)
+    {
+        int netWeight = _graph.getNetWeight(*net);
+        int *count = &_netBlockCount[(size_t)*net * _blockNum];
+        int fromCount = --count[fromBlock], toCount = ++count[toBlock];
+
+        // keep lambda, the cut and the connectivity in step with the pin counts
+        int oldLambda = _netLambda[*net];
+        _netLambda[*net] += (toCount == 1) - (fromCount == 0);
+        _connectivity += (_netLambda[*net] - oldLambda) * netWeight;
+        _cutSize += ((_netLambda[*net] > 1) - (oldLambda > 1)) * netWeight;
+        if (!updateGain)
+        {
+            continue;
+        }
+
+        // delta gains of the free cells on the net, see the four critical pin counts
+        if (toCount == 1 || fromCount == 0)
+        {
+            for (const int *cell = _graph.netCellBegin(*net); cell != _graph.netCellEnd(*net); ++cell)
+            {
+                if (_cellLock[*cell])
+                {
+                    continue;
+                }
+                if (toCount == 1)
+                {
+                    // the net reaches toBlock now, moving there no longer pays for it
+                    int entry = this->findEntry(*cell, toBlock);
+                    if (entry != -1)
+                    {
+                        this->updateEntry(entry, netWeight);
+                    }
+                    else if (_cellBlock[*cell] != toBlock)
+                    {
+                        this->addEntry(*cell, toBlock, this->computeGain(*cell, toBlock));
+                    }
+                }
+                if (fromCount == 0)
+                {
+                    // the net left fromBlock, moving there pays for it again
+                    int entry = this->findEntry(*cell, fromBlock);
+                    if (entry != -1)
+                    {
+                        this->updateEntry(entry, -netWeight);
+                    }
+                }
+            }
+        }
+        if (fromCount == 1 || toCount == 2)
+        {
+            for (const int *cell = _graph.netCellBegin(*net); cell != _graph.netCellEnd(*net); ++cell)
+            {
+                if (_cellLock[*cell])
+                {
+                    continue;
+                }
+                if (fromCount == 1 && _cellBlock[*cell] == fromBlock)
+                {
+                    // the last cell of the net in fromBlock would free the block
+                    this->updateCellEntries(*cell, netWeight);
+                }
+                if (toCount == 2 && _cellBlock[*cell] == toBlock)
+                {
+                    // the cell is no longer alone in toBlock
+                    this->updateCellEntries(*cell, -netWeight);
+                }
+            }
+        }
+    }
+}
+
+void KWayRefiner::refine()
+{
+    _passNum = 0;
+    _passMoveNum.clear();
+    _passKeptNum.clear();
+    while (true)
+    {
+        this->initGain();
+        _stopPolicy->startPass(_passNum, _graph.getCellNum());
+        ++_passNum;
+
+        // move the best feasible cell until the boundary is exhausted
+        int accGain = 0, maxAccGain = 0, bestMoveNum = 0, entry;
+        _moveCell.clear();
+        _moveFrom.clear();
+        while (!_stopPolicy->shouldStop(_moveCell.size(), accGain, maxAccGain) && this->pickMove(entry))
+        {
+            int cellId = _entryCell[entry];
+            accGain += _entryGain[entry];
+            _moveCell.push_back(cellId);
+            _moveFrom.push_back(_cellBlock[cellId]);
+            this->moveCell(cellId, _entryBlock[entry], true);
+            if (accGain > maxAccGain)
+            {
+                maxAccGain = accGain;
+                bestMoveNum = _moveCell.size();
+            }
+        }
+
+        // roll back to the best prefix of the pass
+        for (int i = (int)_moveCell.size() - 1; i >= bestMoveNum; --i)
+        {
+            this->moveCell(_moveCell[i], _moveFrom[i], false);
+        }
+        _moveNum += bestMoveNum;
+        _passMoveNum.push_back(_moveCell.size());
+        _passKeptNum.push_back(bestMoveNum);
+        if (maxAccGain <= 0)
+        {
+            break;
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef KWAYREFINER_H
+#define KWAYREFINER_H
+
+#include <vector>
+#include "hypergraph.h"
+#include "stoppolicy.h"
+using namespace std;
+
+class KWayRefiner
+{
+public:
+    // constructor and destructor, cellBlock holds the initial k-way solution and receives the refined one
+    KWayRefiner(const Hypergraph& graph, int blockNum, double bFactor, vector<int>& cellBlock);
+    ~KWayRefiner() {
+        delete _stopPolicy;
+    }
+
+    // basic access methods
+    int getCutSize() const              { return _cutSize; }
+    int getConnectivity() const         { return _connectivity; }
+    int getBlockSize(int block) const   { return _blockSize[block]; }
+    int getPassNum() const              { return _passNum; }
+    int getMoveNum() const              { return _moveNum; }
+    int getPassMoveNum(int pass) const  { return _passMoveNum[pass]; }
+    int getPassKeptNum(int pass) const  { return _passKeptNum[pass]; }
+
+    // set functions
+    void setStopPolicy(const StopPolicy& stopPolicy) {
+        delete _stopPolicy;
+        _stopPolicy = stopPolicy.clone();
+    }
+
+    // modify method
+    void refine();
+
+private:
+    const Hypergraph&   _graph;         // CSR adjacency of the circuit
+    int                 _blockNum;      // number of blocks k
+    double              _maxBlockSize;  // a block may not grow beyond (1 + b) * W / k
+    vector<int>&        _cellBlock;     // block of each cell
+    vector<int>         _blockSize;     // size (cell weight) of each block
+    vector<int>         _netBlockCount; // cell number of each net in each block, indexed by net * k + block
+    vector<int>         _netLambda;     // number of blocks each net connects
+    int                 _cutSize;       // weight of the nets which connect more than one block
+    int                 _connectivity;  // sum of (lambda - 1) * weight over all nets
+    int                 _maxPinNum;     // Pmax, the largest weighted degree of a cell
+    int                 _passNum;       // number of refinement passes
+    int                 _moveNum;       // number of kept moves over all passes
+    StopPolicy*         _stopPolicy;    // decides when a pass stops moving cells
+    vector<int>         _passMoveNum;   // number of moves tried in each pass
+    vector<int>         _passKeptNum;   // number of moves kept in each pass
+
+    // pass state
+    vector<int>         _cellNetWeight; // total weight of the nets of each cell
+    vector<int>         _benefit;       // weight of the nets a cell would leave behind in its block
+    vector<char>        _cellLock;      // whether each cell has moved in this pass
+    vector<vector<int> > _cellEntries;  // gain entries (one per target block) of each cell
+
+    // gain entries, one bucket list per target block indexed by gain + Pmax
+    vector<int>         _entryCell;     // cell of each entry
+    vector<int>         _entryBlock;    // target block of each entry
+    vector<int>         _entryGain;     // connectivity gain of moving the cell to the target block
+    vector<int>         _entryPrev;     // previous entry in the bucket, -1 at the head
+    vector<int>         _entryNext;     // next entry in the bucket, -1 at the tail
+    vector<int>         _bucketHead;    // first entry of each bucket, indexed by block * (2 * Pmax + 1) + gain + Pmax
+    vector<int>         _maxGainIdx;    // upper bound of the max non-empty bucket index of each block
+
+    vector<int>         _moveCell;      // cells moved in this pass
+    vector<int>         _moveFrom;      // block each moved cell came from
+
+    void initCounts();
+    void initGain();
+    int computeGain(int cellId, int block) const;
+    int findEntry(int cellId, int block) const;
+    void addEntry(int cellId, int block, int gain);
+    void insertEntry(int entry);
+    void removeEntry(int entry);
+    void updateEntry(int entry, int delta);
+    void updateCellEntries(int cellId, int delta);
+    bool pickMove(int& entry);
+    void moveCell(int cellId, int toBlock, bool updateGain);
+};
+
+#endif  // KWAYREFINER_H
@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "labelprop.h"
+#include "threadpool.h"
+using namespace std;
+
+void LabelPropPartitioner::findCandidates(int fromPart, bool zeroGain, int beginCell, int endCell, vector<int> &candidates)
+{
+    // collect the cells of fromPart in [beginCell, endCell) whose move would reduce the cut, or keep it if zeroGain
+    const Hypergraph &graph = _partitioner.getGraph();
+    candidates.clear();
+    for (int i = beginCell; i < endCell; ++i)
+    {
+        if (_cellPart[i] != fromPart)
+        {
+            continue;
+        }
+        int gain = 0;
+        for (const int *net = graph.cellNetBegin(i); net != graph.cellNetEnd(i); ++net)
+        {
+            if (_netPartCount[2 * *net + fromPart] == 1)
+            {
+                gain += graph.getNetWeight(*net);
+            }
+            if (_netPartCount[2 * *net + !fromPart] == 0)
+            {
+                gain -= graph.getNetWeight(*net);
+            }
+        }
+        if (gain > 0 || (zeroGain && gain == 0))
+        {
+            _cellGain[i] = gain;
+            candidates.push_back(i);
+        }
+    }
+}
+
+void LabelPropPartitioner::partition()
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    int cellNum = graph.getCellNum();
+    _partitioner.initPartition();
+    cout << "Initial cutsize: " << _partitioner.getCutSize() << endl;
+
+    _cellPart.resize(cellNum);
+    _cellGain.assign(cellNum, 0);
+    _netPartCount.resize(2 * graph.getNetNum());
+    int partSize[2] = {_partitioner.getPartSize(0), _partitioner.getPartSize(1)};
+    for (int i = 0; i < cellNum; ++i)
+    {
+        _cellPart[i] = _partitioner.getCellPart(i);
+    }
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        _netPartCount[2 * i] = _partitioner.getNetPartCount(i, 0);
+        _netPartCount[2 * i + 1] = _partitioner.getNetPartCount(i, 1);
+    }
+    double lowerBound[2] = {_partitioner.getLowerBound(0), _partitioner.getLowerBound(1)};
+    double upperBound[2] = {_partitioner.getUpperBound(0), _partitioner.getUpperBound(1)};
+    double targetSize[2] = {_partitioner.getTargetRatio() * graph.getTotalCellWeight(), 0};
+    targetSize[1] = graph.getTotalCellWeight() - targetSize[0];
+
+    // a round moves cells out of one side only, cells leaving the same side together never gain less
+    // than the sum of their own gains, so the cut cannot grow; a side above its target share also gives
+    // up zero-gain cells while it stays at or above that share, so a round either lowers the cut or only
+    // brings the sides closer to their targets and the rounds converge; stop once both sides stay idle
+    ThreadPool pool(_threadNum);
+    int taskNum = pool.getThreadNum();
+    vector<vector<int> > taskCandidates(taskNum);
+    vector<int> candidates;
+    int idleNum = 0;
+    _moveNum = 0;
+    for (_roundNum = 0; (_maxRoundNum == 0 || _roundNum < _maxRoundNum) && idleNum < 2; ++_roundNum)
+    {
+        int fromPart = _roundNum % 2;
+        bool zeroGain = partSize[fromPart] > targetSize[fromPart];
+        for (int i = 0; i < taskNum; ++i)
+        {
+            int beginCell = (long long)cellNum * i / taskNum, endCell = (long long)cellNum * (i + 1) / taskNum;
+            pool.submit([this, fromPart, zeroGain, beginCell, endCell, i, &taskCandidates]
+                        { this->findCandidates(fromPart, zeroGain, beginCell, endCell, taskCandidates[i]); });
+        }
+        pool.wait();
+
+        // take the candidates by decreasing gain (then by id, independent of the thread count) while balance allows
+        candidates.clear();
+        for (int i = 0; i < taskNum; ++i)
+        {
+            candidates.insert(candidates.end(), taskCandidates[i].begin(), taskCandidates[i].end());
+        }
+        sort(candidates.begin(), candidates.end(), [this](int a, int b)
+             { return _cellGain[a] != _cellGain[b] ? _cellGain[a] > _cellGain[b] : a < b; });
+        int roundMoveNum = 0;
+        for (size_t i = 0; i < candidates.size(); ++i)
+        {
+            int cellId = candidates[i], weight = graph.getCellWeight(cellId);
+            if (partSize[fromPart] - weight < lowerBound[fromPart] || partSize[!fromPart] + weight > upperBound[!fromPart] ||
+                (_cellGain[cellId] == 0 && partSize[fromPart] - weight < targetSize[fromPart]))
+            {
+                continue;
+            }
+            _cellPart[cellId] = !fromPart;
+            partSize[fromPart] -= weight;
+            partSize[!fromPart] += weight;
+            for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+            {
+                _netPartCount[2 * *net + fromPart]--;
+                _netPartCount[2 * *net + !fromPart]++;
+            }
+            ++roundMoveNum;
+        }
+        _moveNum += roundMoveNum;
+        idleNum = roundMoveNum == 0 ? idleNum + 1 : 0;
+    }
+
+    _partitioner.initPartition(_cellPart);
+    cout << "Label propagation cutsize: " << _partitioner.getCutSize() << " (" << _moveNum << " moves in " << _roundNum << " rounds)" << endl;
+    if (_polishPassNum > 0)
+    {
+        _partitioner.setMaxPassNum(_polishPassNum);
+        _partitioner.refine();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef LABELPROP_H
+#define LABELPROP_H
+
+#include <vector>
+#include "hypergraph.h"
+#include "partitioner.h"
+using namespace std;
+
+// size-constrained label propagation, every round moves the cells with a positive gain (and, from the side above
+// its target share, those with a zero gain) out of one side in parallel until no side has a move left
+class LabelPropPartitioner
+{
+public:
+    // constructor and destructor, threadNum <= 0 means one thread per hardware thread
+    LabelPropPartitioner(Partitioner& partitioner, int threadNum) :
+        _partitioner(partitioner), _threadNum(threadNum), _maxRoundNum(0), _polishPassNum(0), _roundNum(0), _moveNum(0) { }
+    ~LabelPropPartitioner() { }
+
+    // basic access methods
+    int getRoundNum() const         { return _roundNum; }
+    int getMoveNum() const          { return _moveNum; }
+
+    // set functions
+    // stop after this many rounds even before convergence, 0 means no bound
+    void setMaxRoundNum(const int maxRoundNum)      { _maxRoundNum = maxRoundNum; }
+    // number of F-M passes run on the result, 0 for none
+    void setPolishPassNum(const int polishPassNum)  { _polishPassNum = polishPassNum; }
+
+    // modify method
+    void partition();
+
+private:
+    Partitioner&        _partitioner;   // partitioner which provides the initial and receives the final partition
+    int                 _threadNum;     // number of worker threads
+    int                 _maxRoundNum;   // upper bound of the propagation rounds, 0 for none
+    int                 _polishPassNum; // number of F-M passes after the propagation
+    int                 _roundNum;      // number of rounds run
+    int                 _moveNum;       // number of moved cells over all rounds
+    vector<char>        _cellPart;      // partition of each cell (0-A, 1-B)
+    vector<int>         _cellGain;      // gain of each candidate cell in the current round
+    vector<int>         _netPartCount;  // cell number of each net in A(2 * id) and B(2 * id + 1)
+
+    void findCandidates(int fromPart, bool zeroGain, int beginCell, int endCell, vector<int>& candidates);
+};
+
+#endif  // LABELPROP_H
@@ -1,38 +1,280 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <algorithm>
+#include <string.h>
 #include <time.h> 
+#include <chrono>
+#include <sys/resource.h>
 #include "partitioner.h"
+#include "multilevel.h"
+#include "multistart.h"
+#include "memetic.h"
+#include "labelprop.h"
+#include "parallelfm.h"
+#include "eco.h"
+#include "stream.h"
+#include "kway.h"
+#include "profile.h"
 using namespace std;
 
+// bisection of the parsed circuit in the selected mode
+static void partitionTwoWay(Partitioner& partitioner, bool multilevel, bool parallelFM, int polishPassNum, int startNum, int threadNum, const char* ecoName,
+                            int populationSize, double timeLimit)
+{
+    // a single run spends the threads on the gain initialization of its own refinement
+    partitioner.setThreadNum(threadNum);
+    if (ecoName != NULL) {
+        EcoPartitioner ecoPartitioner(partitioner, ecoName);
+        ecoPartitioner.partition();
+    }
+    else if (populationSize > 0) {
+        MemeticPartitioner memeticPartitioner(partitioner, populationSize, timeLimit, threadNum);
+        memeticPartitioner.setMultilevel(multilevel);
+        memeticPartitioner.partition();
+        const vector<MemeticTrace>& trace = memeticPartitioner.getTrace();
+        for (size_t i = 0; i < trace.size(); ++i) {
+            cout << "Generation " << trace[i].generation << " cutsize: " << trace[i].bestCutSize << " (" << trace[i].seconds << " seconds)" << endl;
+        }
+        cout << "Memetic: " << memeticPartitioner.getGenerationNum() << " generations, " << memeticPartitioner.getChildNum() << " children accepted" << endl;
+    }
+    else if (startNum > 1) {
+        MultiStartPartitioner multiStartPartitioner(partitioner, startNum, threadNum);
+        multiStartPartitioner.setMultilevel(multilevel);
+        multiStartPartitioner.partition();
+    }
+    else if (multilevel) {
+        MultilevelPartitioner multilevelPartitioner(partitioner);
+        multilevelPartitioner.partition();
+    }
+    else if (parallelFM || polishPassNum >= 0) {
+        if (polishPassNum >= 0) {
+            LabelPropPartitioner labelPropPartitioner(partitioner, threadNum);
+            labelPropPartitioner.setPolishPassNum(polishPassNum);
+            labelPropPartitioner.partition();
+        }
+        else {
+            partitioner.initPartition();
+            cout << "Initial cutsize: " << partitioner.getCutSize() << endl;
+        }
+        if (parallelFM) {
+            ParallelFMRefiner refiner(partitioner, threadNum);
+            refiner.refine();
+            cout << "Parallel F-M: " << refiner.getMoveNum() << " moves in " << refiner.getRoundNum() << " rounds" << endl;
+        }
+    }
+    else {
+        partitioner.partition();
+    }
+}
+
+// write the profile of the run with its peak resident memory
+static void writeProfile(const char* profileName, Profile& profile, int cutSize)
+{
+    // ru_maxrss is in kilobytes on Linux
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    profile.setResult(cutSize, usage.ru_maxrss);
+    ofstream profileFile(profileName);
+    if (!profileFile) {
+        cerr << "Cannot open the profile file \"" << profileName << "\"." << endl;
+        exit(1);
+    }
+    profile.writeJson(profileFile);
+}
+
 int main(int argc, char** argv)
 {
-    fstream input, output;
+    fstream output;
+    bool multilevel = false, parallelFM = false, growInit = false;
+    int startNum = 1, threadNum = 0, blockNum = 2, polishPassNum = -1, streamWindow = -1, populationSize = 0, largeNetSize = 0;
+    double timeLimit = 0;
+    char* snapshotName = NULL;
+    char* profileName = NULL;
+    char* ecoName = NULL;
+    StopPolicy* stopPolicy = NULL;
+    BucketPolicy bucketPolicy = BUCKET_INDEX;
+    vector<char*> fileNames;
 
-    if (argc == 3) {
-        input.open(argv[1], ios::in);
-        output.open(argv[2], ios::out);
-        if (!input) {
-            cerr << "Cannot open the input file \"" << argv[1]
-                 << "\". The program will be terminated..." << endl;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-ml") == 0) {
+            multilevel = true;
+        }
+        else if (strcmp(argv[i], "-pfm") == 0) {
+            parallelFM = true;
+        }
+        else if (strcmp(argv[i], "-grow") == 0) {
+            growInit = true;
+        }
+        else if (strcmp(argv[i], "-lp") == 0 && i + 1 < argc) {
+            polishPassNum = max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-ms") == 0 && i + 1 < argc) {
+            startNum = max(1, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-memetic") == 0 && i + 2 < argc) {
+            populationSize = max(2, atoi(argv[++i]));
+            timeLimit = max(0.0, atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            blockNum = atoi(argv[++i]);
+            if (blockNum < 2 || blockNum > 256) {
+                cerr << "The block number should be between 2 and 256." << endl;
+                exit(1);
+            }
+        }
+        else if (strcmp(argv[i], "-adaptive") == 0 && i + 2 < argc) {
+            int distance = atoi(argv[++i]);
+            int window = atoi(argv[++i]);
+            delete stopPolicy;
+            stopPolicy = new AdaptiveStop(max(1, distance), max(1, window));
+        }
+        else if (strcmp(argv[i], "-bucket") == 0 && i + 1 < argc) {
+            const char* policyNames[] = {"index", "lifo", "fifo", "random", "clip"};
+            const char* policyName = argv[++i];
+            int policy = 0;
+            while (policy < 5 && strcmp(policyName, policyNames[policy]) != 0) {
+                ++policy;
+            }
+            if (policy == 5) {
+                cerr << "The bucket policy should be index, lifo, fifo, random or clip." << endl;
+                exit(1);
+            }
+            bucketPolicy = (BucketPolicy)policy;
+        }
+        else if (strcmp(argv[i], "-largenet") == 0 && i + 1 < argc) {
+            largeNetSize = max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-cache") == 0 && i + 1 < argc) {
+            snapshotName = argv[++i];
+        }
+        else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc) {
+            profileName = argv[++i];
+        }
+        else if (strcmp(argv[i], "-eco") == 0 && i + 1 < argc) {
+            ecoName = argv[++i];
+        }
+        else if (strcmp(argv[i], "-stream") == 0 && i + 1 < argc) {
+            streamWindow = max(0, atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            threadNum = atoi(argv[++i]);
+        }
+        else {
+            fileNames.push_back(argv[i]);
+        }
+    }
+
+    // one mode per run, except that -ml also drives -k, -ms and -memetic and -pfm refines the -lp result
+    const char* modeNames[] = {"-k", "-ml", "-lp", "-pfm", "-ms", "-memetic", "-eco", "-stream"};
+    bool modeGiven[] = {blockNum > 2, multilevel, polishPassNum >= 0, parallelFM, startNum > 1, populationSize > 0, ecoName != NULL, streamWindow >= 0};
+    const int compatibleModes[][2] = {{0, 1}, {1, 4}, {1, 5}, {2, 3}};
+    for (int i = 0; i < 8; ++i) {
+        for (int j = i + 1; j < 8; ++j) {
+            bool compatible = false;
+            for (int k = 0; k < 4; ++k) {
+                compatible = compatible || (compatibleModes[k][0] == i && compatibleModes[k][1] == j);
+            }
+            if (modeGiven[i] && modeGiven[j] && !compatible) {
+                cerr << "The " << modeNames[i] << " and " << modeNames[j] << " modes cannot be combined." << endl;
+                exit(1);
+            }
+        }
+    }
+
+    // the streaming mode keeps no hypergraph, the options of the in-memory F-M do not reach it
+    const char* optionNames[] = {"-grow", "-bucket", "-largenet", "-adaptive", "-cache"};
+    bool optionGiven[] = {growInit, bucketPolicy != BUCKET_INDEX, largeNetSize > 0, stopPolicy != NULL, snapshotName != NULL};
+    for (int i = 0; i < 5 && streamWindow >= 0; ++i) {
+        if (optionGiven[i]) {
+            cerr << "The " << optionNames[i] << " option cannot be combined with the -stream mode." << endl;
             exit(1);
         }
+    }
+
+    if (fileNames.size() == 2) {
+        output.open(fileNames[1], ios::out);
         if (!output) {
-            cerr << "Cannot open the output file \"" << argv[2]
+            cerr << "Cannot open the output file \"" << fileNames[1]
                  << "\". The program will be terminated..." << endl;
             exit(1);
         }
     }
     else {
-        cerr << "Usage: ./fm <input file> <output file>" << endl;
+        cerr << "Usage: ./fm [-k <block number>] [-ml] [-grow] [-lp <polish passes>] [-pfm] [-ms <start number>] [-memetic <population> <seconds>] [-t <thread number>] [-adaptive <distance> <window>] [-bucket <index|lifo|fifo|random|clip>] [-largenet <pins>] [-cache <snapshot file>] [-profile <json file>] [-eco <previous result>] [-stream <window nets>] <input file> <output file>" << endl;
         exit(1);
     }
 
-    Partitioner* partitioner = new Partitioner(input);
-    partitioner->partition();
-    partitioner->printSummary();
-    partitioner->writeResult(output);
+    // the streaming mode never builds the hypergraph, only per-cell state
+    if (streamWindow >= 0) {
+        Profile profile;
+        chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+        StreamPartitioner streamPartitioner(fileNames[0]);
+        streamPartitioner.setWindowNetNum(streamWindow);
+        streamPartitioner.partition();
+        profile.addPhase("stream", secondsSince(phaseStart));
+        streamPartitioner.printSummary();
+        phaseStart = chrono::steady_clock::now();
+        streamPartitioner.writeResult(output);
+        output.close();
+        profile.addPhase("write", secondsSince(phaseStart));
+        cout << "total runtime: " << (double)clock() / CLOCKS_PER_SEC << " seconds" << endl;
+        if (profileName != NULL) {
+            writeProfile(profileName, profile, streamPartitioner.getCutSize());
+        }
+        return 0;
+    }
+
+    chrono::steady_clock::time_point parseStart = chrono::steady_clock::now();
+    Partitioner* partitioner = new Partitioner(fileNames[0], snapshotName);
+    double parseTime = chrono::duration<double>(chrono::steady_clock::now() - parseStart).count();
+    partitioner->setGrowInit(growInit);
+    partitioner->setBucketPolicy(bucketPolicy);
+    partitioner->setLargeNetSize(largeNetSize);
+    if (stopPolicy != NULL) {
+        partitioner->setStopPolicy(*stopPolicy);
+        delete stopPolicy;
+    }
+    cout << (partitioner->isFromSnapshot() ? "Snapshot load: " : "Parse: ") << partitioner->getInputSize() / 1e6 << " MB in " << parseTime << " seconds ("
+         << (parseTime > 0 ? partitioner->getInputSize() / 1e6 / parseTime : 0) << " MB/s)" << endl;
+    Profile profile;
+    profile.addPhase(partitioner->isFromSnapshot() ? "snapshot_load" : "parse", parseTime);
+    chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+    int cutSize;
+    if (blockNum > 2) {
+        KWayPartitioner kWayPartitioner(*partitioner, blockNum, threadNum);
+        kWayPartitioner.setMultilevel(multilevel);
+        kWayPartitioner.partition();
+        profile.addPhase("partition", secondsSince(phaseStart));
+        kWayPartitioner.printSummary();
+        phaseStart = chrono::steady_clock::now();
+        kWayPartitioner.writeResult(output);
+        cutSize = kWayPartitioner.getCutSize();
+    }
+    else {
+        partitionTwoWay(*partitioner, multilevel, parallelFM, polishPassNum, startNum, threadNum, ecoName, populationSize, timeLimit);
+        if (largeNetSize > 0) {
+            // the drift is known only when the final refinement ran on this partitioner, not in workers
+            cout << "Large nets: " << partitioner->getLargeNetNum() << " above " << largeNetSize << " pins";
+            if (partitioner->getPassNum() > 0) {
+                cout << ", cut drift " << partitioner->getCutDrift();
+            }
+            cout << endl;
+        }
+        profile.addPhase("partition", secondsSince(phaseStart));
+        partitioner->printSummary();
+        phaseStart = chrono::steady_clock::now();
+        partitioner->writeResult(output);
+        cutSize = partitioner->getCutSize();
+    }
+    output.close();
+    profile.addPhase("write", secondsSince(phaseStart));
     cout << "total runtime: " << (double)clock() / CLOCKS_PER_SEC << " seconds" << endl;
 
+    if (profileName != NULL) {
+        profile.setPasses(partitioner->getPassProfile());
+        writeProfile(profileName, profile, cutSize);
+    }
+    delete partitioner;
     return 0;
 }
@@ -0,0 +1,261 @@
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+#include <chrono>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "multilevel.h"
+#include "memetic.h"
+#include "threadpool.h"
+#include "profile.h"
+using namespace std;
+
+// whether cut size a beats cut size b, an unbalanced member (-1) loses to every balanced one
+static bool isBetterCut(int a, int b)
+{
+    return a >= 0 && (b < 0 || a < b);
+}
+
+// root of a cell in the cluster forest, halving the path on the way
+static int findCluster(vector<int> &cluster, int cellId)
+{
+    while (cluster[cellId] != cellId)
+    {
+        cluster[cellId] = cluster[cluster[cellId]];
+        cellId = cluster[cellId];
+    }
+    return cellId;
+}
+
+void MemeticPartitioner::initMember(int member)
+{
+    // every member owns its partitioner workspace, only the hypergraph is shared
+    Partitioner worker(_partitioner.getGraph(), _partitioner.getBFactor());
+    worker.setTargetRatio(_partitioner.getTargetRatio());
+    worker.setStopPolicy(_partitioner.getStopPolicy());
+    worker.setBucketPolicy(_partitioner.getBucketPolicy());
+    worker.setLargeNetSize(_partitioner.getLargeNetSize());
+    worker.setGrowInit(_partitioner.isGrowInit());
+    if (_multilevel)
+    {
+        MultilevelPartitioner multilevelPartitioner(worker);
+        multilevelPartitioner.setSeed(member);
+        multilevelPartitioner.setVerbose(false);
+        multilevelPartitioner.partition();
+    }
+    else
+    {
+        // member 0 keeps the deterministic initial partition
+        if (member == 0)
+        {
+            worker.initPartition();
+        }
+        else
+        {
+            worker.initPerturbedPartition(member);
+        }
+        worker.refine();
+    }
+    worker.getPartition(_memberPart[member]);
+    _memberCutSize[member] = worker.isBalanced() ? worker.getCutSize() : -1;
+}
+
+int MemeticPartitioner::selectParent()
+{
+    // binary tournament
+    int a = _rng() % _populationSize, b = _rng() % _populationSize;
+    return isBetterCut(_memberCutSize[b], _memberCutSize[a]) ? b : a;
+}
+
+void MemeticPartitioner::recombine(int parentA, int parentB, vector<char> &childPart, int &childCutSize) const
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    const vector<char> &partA = _memberPart[parentA], &partB = _memberPart[parentB];
+    int cellNum = graph.getCellNum();
+
+    // merge the pins of every net which neither parent cuts, so a cluster lies on one side in both parents
+    vector<int> cluster(cellNum), clusterWeight(cellNum);
+    iota(cluster.begin(), cluster.end(), 0);
+    for (int i = 0; i < cellNum; ++i)
+    {
+        clusterWeight[i] = graph.getCellWeight(i);
+    }
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        const int *begin = graph.netCellBegin(i), *end = graph.netCellEnd(i);
+        bool uncut = true;
+        for (const int *cell = begin + 1; uncut && cell != end; ++cell)
+        {
+            uncut = partA[*cell] == partA[*begin] && partB[*cell] == partB[*begin];
+        }
+        if (!uncut)
+        {
+            continue;
+        }
+        for (const int *cell = begin + 1; cell != end; ++cell)
+        {
+            int rootA = findCluster(cluster, *begin), rootB = findCluster(cluster, *cell);
+            if (rootA != rootB && clusterWeight[rootA] + clusterWeight[rootB] <= _maxClusterWeight)
+            {
+                cluster[rootB] = rootA;
+                clusterWeight[rootA] += clusterWeight[rootB];
+            }
+        }
+    }
+
+    vector<int> clusterId(cellNum, -1), fineToCoarse(cellNum);
+    int coarseCellNum = 0;
+    for (int i = 0; i < cellNum; ++i)
+    {
+        int root = findCluster(cluster, i);
+        if (clusterId[root] == -1)
+        {
+            clusterId[root] = coarseCellNum++;
+        }
+        fineToCoarse[i] = clusterId[root];
+    }
+
+    // refine the better parent on the contracted hypergraph, where only the disagreement can move freely
+    vector<char> coarsePart(coarseCellNum);
+    {
+        Hypergraph coarse;
+        MultilevelPartitioner::contract(graph, fineToCoarse, coarseCellNum, coarse);
+        for (int i = 0; i < cellNum; ++i)
+        {
+            coarsePart[fineToCoarse[i]] = partA[i];
+        }
+        Partitioner refiner(coarse, _partitioner.getBFactor());
+        refiner.setTargetRatio(_partitioner.getTargetRatio());
+        refiner.setStopPolicy(_partitioner.getStopPolicy());
+        refiner.setBucketPolicy(_partitioner.getBucketPolicy());
+        refiner.setLargeNetSize(_partitioner.getLargeNetSize());
+        refiner.initPartition(coarsePart);
+        refiner.refine();
+        refiner.getPartition(coarsePart);
+    }
+
+    // project back and let F-M split the clusters where it pays
+    childPart.resize(cellNum);
+    for (int i = 0; i < cellNum; ++i)
+    {
+        childPart[i] = coarsePart[fineToCoarse[i]];
+    }
+    Partitioner refiner(graph, _partitioner.getBFactor());
+    refiner.setTargetRatio(_partitioner.getTargetRatio());
+    refiner.setStopPolicy(_partitioner.getStopPolicy());
+    refiner.setBucketPolicy(_partitioner.getBucketPolicy());
+    refiner.setLargeNetSize(_partitioner.getLargeNetSize());
+    refiner.initPartition(childPart);
+    refiner.refine();
+    refiner.getPartition(childPart);
+    childCutSize = refiner.isBalanced() ? refiner.getCutSize() : -1;
+}
+
+bool MemeticPartitioner::insertChild(const vector<char> &childPart, int childCutSize)
+{
+    // the child replaces the worst member unless it is worse or already in the population
+    int worst = 0;
+    for (int i = 0; i < _populationSize; ++i)
+    {
+        if (_memberCutSize[i] == childCutSize && _memberPart[i] == childPart)
+        {
+            return false;
+        }
+        if (isBetterCut(_memberCutSize[worst], _memberCutSize[i]))
+        {
+            worst = i;
+        }
+    }
+    if (childCutSize < 0 || isBetterCut(_memberCutSize[worst], childCutSize))
+    {
+        return false;
+    }
+    _memberPart[worst] = childPart;
+    _memberCutSize[worst] = childCutSize;
+    return true;
+}
+
+void MemeticPartitioner::updateBest()
+{
+    _bestMember = 0;
+    for (int i = 1; i < _populationSize; ++i)
+    {
+        if (isBetterCut(_memberCutSize[i], _memberCutSize[_bestMember]))
+        {
+            _bestMember = i;
+        }
+    }
+}
+
+void MemeticPartitioner::partition()
+{
+    chrono::steady_clock::time_point searchStart = chrono::steady_clock::now();
+    const Hypergraph &graph = _partitioner.getGraph();
+    double bFactor = _partitioner.getBFactor(), targetRatio = _partitioner.getTargetRatio();
+
+    // a cluster light enough to cross sides without breaking the balance on its own
+    _maxClusterWeight = max(1, (int)(0.5 * bFactor * graph.getTotalCellWeight() * min(targetRatio, 1 - targetRatio)));
+    _populationSize = max(2, _populationSize);
+    _memberPart.assign(_populationSize, vector<char>());
+    _memberCutSize.assign(_populationSize, -1);
+    _generationNum = 0;
+    _childNum = 0;
+    _trace.clear();
+
+    ThreadPool pool(_threadNum);
+    for (int i = 0; i < _populationSize; ++i)
+    {
+        pool.submit([this, i]
+                    { this->initMember(i); });
+    }
+    pool.wait();
+    this->updateBest();
+    MemeticTrace point = {0, secondsSince(searchStart), _memberCutSize[_bestMember]};
+    _trace.push_back(point);
+
+    // a generation breeds one child per worker, parents are drawn here so the choice does not depend on timing
+    int batchSize = pool.getThreadNum();
+    vector<vector<char> > childPart(batchSize);
+    vector<int> childCutSize(batchSize);
+    while (secondsSince(searchStart) < _timeLimit && (_maxGenerationNum == 0 || _generationNum < _maxGenerationNum))
+    {
+        ++_generationNum;
+        for (int i = 0; i < batchSize; ++i)
+        {
+            int parentA = this->selectParent(), parentB = this->selectParent();
+            while (parentB == parentA)
+            {
+                parentB = this->selectParent();
+            }
+            if (isBetterCut(_memberCutSize[parentB], _memberCutSize[parentA]))
+            {
+                swap(parentA, parentB);
+            }
+            pool.submit([this, i, parentA, parentB, &childPart, &childCutSize]
+                        { this->recombine(parentA, parentB, childPart[i], childCutSize[i]); });
+        }
+        pool.wait();
+
+        int bestCutSize = _memberCutSize[_bestMember];
+        for (int i = 0; i < batchSize; ++i)
+        {
+            if (this->insertChild(childPart[i], childCutSize[i]))
+            {
+                ++_childNum;
+            }
+        }
+        this->updateBest();
+        if (_memberCutSize[_bestMember] != bestCutSize)
+        {
+            MemeticTrace point = {_generationNum, secondsSince(searchStart), _memberCutSize[_bestMember]};
+            _trace.push_back(point);
+        }
+    }
+
+    if (_memberCutSize[_bestMember] < 0)
+    {
+        cerr << "No balanced solution among " << _populationSize << " members." << endl;
+    }
+    _partitioner.initPartition(_memberPart[_bestMember]);
+}
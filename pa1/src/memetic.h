@@ -0,0 +1,69 @@
+#ifndef MEMETIC_H
+#define MEMETIC_H
+
+#include <vector>
+#include <random>
+#include "hypergraph.h"
+#include "partitioner.h"
+using namespace std;
+
+// one point of the convergence trace, recorded for the initial population and whenever the best cut drops
+struct MemeticTrace
+{
+    int     generation;     // generation which produced the cut, 0 for the initial population
+    double  seconds;        // wall-clock time since the search started
+    int     bestCutSize;    // minimum balanced cut in the population
+};
+
+// memetic bisection, a population of F-M partitions is recombined pair by pair: cells which share a side in
+// both parents are contracted along the nets neither parent cuts, and F-M refines the child on that graph
+class MemeticPartitioner
+{
+public:
+    // constructor and destructor, the search stops at the first generation ending after timeLimit seconds,
+    // threadNum <= 0 means one thread per hardware thread
+    MemeticPartitioner(Partitioner& partitioner, int populationSize, double timeLimit, int threadNum) :
+        _partitioner(partitioner), _populationSize(populationSize), _timeLimit(timeLimit), _threadNum(threadNum),
+        _multilevel(false), _maxGenerationNum(0), _maxClusterWeight(1), _generationNum(0), _childNum(0), _bestMember(-1), _rng(0) { }
+    ~MemeticPartitioner() { }
+
+    // basic access methods
+    int getPopulationSize() const               { return _populationSize; }
+    int getGenerationNum() const                { return _generationNum; }
+    int getChildNum() const                     { return _childNum; }
+    int getBestCutSize() const                  { return _memberCutSize[_bestMember]; }
+    const vector<MemeticTrace>& getTrace() const    { return _trace; }
+
+    // set functions
+    void setMultilevel(const bool multilevel)           { _multilevel = multilevel; }
+    // stop after this many generations even within the time limit, 0 means no bound
+    void setMaxGenerationNum(const int maxGenerationNum)    { _maxGenerationNum = maxGenerationNum; }
+    void setSeed(const unsigned seed)                   { _rng.seed(seed); }
+
+    // modify method
+    void partition();
+
+private:
+    Partitioner&            _partitioner;       // partitioner which receives the best member
+    int                     _populationSize;    // number of members
+    double                  _timeLimit;         // wall-clock budget of the search in seconds
+    int                     _threadNum;         // number of worker threads
+    bool                    _multilevel;        // whether the initial members run the multilevel flow
+    int                     _maxGenerationNum;  // upper bound of the generations, 0 for none
+    int                     _maxClusterWeight;  // upper bound of the weight of a contracted cluster
+    int                     _generationNum;     // number of generations run
+    int                     _childNum;          // number of children accepted into the population
+    int                     _bestMember;        // member with the minimum balanced cut
+    mt19937                 _rng;               // parent selection, drawn on the calling thread only
+    vector<vector<char> >   _memberPart;        // partition of each member
+    vector<int>             _memberCutSize;     // cut size of each member, -1 if unbalanced
+    vector<MemeticTrace>    _trace;             // convergence trace
+
+    void initMember(int member);
+    int selectParent();
+    void recombine(int parentA, int parentB, vector<char>& childPart, int& childCutSize) const;
+    bool insertChild(const vector<char>& childPart, int childCutSize);
+    void updateBest();
+};
+
+#endif  // MEMETIC_H
@@ -0,0 +1,285 @@
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <random>
+#include <algorithm>
+#include <memory>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "multilevel.h"
+using namespace std;
+
+int MultilevelPartitioner::matchCells(const Hypergraph &fine, vector<int> &fineToCoarse) const
+{
+    // first-choice clustering: each free cell joins the neighbor cluster it shares the heaviest nets with
+    int cellNum = fine.getCellNum();
+    vector<int> cluster(cellNum, -1);
+    vector<int> clusterWeight(cellNum);
+    vector<double> rating(cellNum, 0);
+    vector<int> touched;
+    for (int i = 0; i < cellNum; ++i)
+    {
+        clusterWeight[i] = fine.getCellWeight(i);
+    }
+
+    // visit the cells in a seeded random order
+    vector<int> order(cellNum);
+    iota(order.begin(), order.end(), 0);
+    shuffle(order.begin(), order.end(), mt19937(_seed + cellNum));
+
+    for (int i = 0; i < cellNum; ++i)
+    {
+        int cellId = order[i];
+        if (cluster[cellId] != -1)
+        {
+            continue;
+        }
+
+        // rate the neighbor clusters by sum of w(e)/(|e|-1)
+        touched.clear();
+        for (const int *net = fine.cellNetBegin(cellId); net != fine.cellNetEnd(cellId); ++net)
+        {
+            int netSize = fine.getNetSize(*net);
+            if (netSize < 2 || netSize > _largeNetSize)
+            {
+                continue;
+            }
+            double score = (double)fine.getNetWeight(*net) / (netSize - 1);
+            for (const int *cell = fine.netCellBegin(*net); cell != fine.netCellEnd(*net); ++cell)
+            {
+                if (*cell == cellId)
+                {
+                    continue;
+                }
+                int target = cluster[*cell] == -1 ? *cell : cluster[*cell];
+                if (rating[target] == 0)
+                {
+                    touched.push_back(target);
+                }
+                rating[target] += score;
+            }
+        }
+
+        // pick the best rated cluster which stays under the weight bound
+        int bestTarget = -1;
+        double bestRating = 0;
+        for (size_t j = 0; j < touched.size(); ++j)
+        {
+            int target = touched[j];
+            if (clusterWeight[target] + fine.getCellWeight(cellId) <= _maxClusterWeight && rating[target] > bestRating)
+            {
+                bestTarget = target;
+                bestRating = rating[target];
+            }
+            rating[target] = 0;
+        }
+
+        if (bestTarget == -1)
+        {
+            cluster[cellId] = cellId;
+        }
+        else
+        {
+            cluster[bestTarget] = bestTarget;
+            cluster[cellId] = bestTarget;
+            clusterWeight[bestTarget] += fine.getCellWeight(cellId);
+        }
+    }
+
+    // number the clusters in order of their first fine cell
+    int coarseCellNum = 0;
+    vector<int> coarseId(cellNum, -1);
+    fineToCoarse.resize(cellNum);
+    for (int i = 0; i < cellNum; ++i)
+    {
+        int root = cluster[i];
+        if (coarseId[root] == -1)
+        {
+            coarseId[root] = coarseCellNum++;
+        }
+        fineToCoarse[i] = coarseId[root];
+    }
+    return coarseCellNum;
+}
+
+void MultilevelPartitioner::contract(const Hypergraph &fine, const vector<int> &fineToCoarse, int coarseCellNum, Hypergraph &coarse)
+{
+    // coarse cells carry the total weight of their cluster
+    vector<int> coarseWeight(coarseCellNum, 0);
+    for (int i = 0; i < fine.getCellNum(); ++i)
+    {
+        coarseWeight[fineToCoarse[i]] += fine.getCellWeight(i);
+    }
+    for (int i = 0; i < coarseCellNum; ++i)
+    {
+        coarse.addCell(coarseWeight[i]);
+    }
+
+    // map the pins, drop duplicated pins and nets which fall inside a single cluster
+    vector<int> netStart(1, 0), netPins, netWeight;
+    vector<unsigned long long> netHash;
+    vector<int> mark(coarseCellNum, -1);
+    for (int i = 0; i < fine.getNetNum(); ++i)
+    {
+        int start = netPins.size();
+        for (const int *cell = fine.netCellBegin(i); cell != fine.netCellEnd(i); ++cell)
+        {
+            int coarseCell = fineToCoarse[*cell];
+            if (mark[coarseCell] != i)
+            {
+                mark[coarseCell] = i;
+                netPins.push_back(coarseCell);
+            }
+        }
+        if (netPins.size() - start < 2)
+        {
+            netPins.resize(start);
+            continue;
+        }
+        sort(netPins.begin() + start, netPins.end());
+        unsigned long long hash = netPins.size() - start;
+        for (size_t j = start; j < netPins.size(); ++j)
+        {
+            hash = hash * 1000003ULL + netPins[j];
+        }
+        netStart.push_back(netPins.size());
+        netWeight.push_back(fine.getNetWeight(i));
+        netHash.push_back(hash);
+    }
+
+    // merge parallel nets into one heavier net
+    int netNum = netWeight.size();
+    vector<int> byHash(netNum);
+    vector<char> merged(netNum, false);
+    iota(byHash.begin(), byHash.end(), 0);
+    sort(byHash.begin(), byHash.end(), [&netHash](int a, int b)
+         { return netHash[a] != netHash[b] ? netHash[a] < netHash[b] : a < b; });
+    for (int i = 0; i < netNum; ++i)
+    {
+        int netA = byHash[i];
+        if (merged[netA])
+        {
+            continue;
+        }
+        for (int j = i + 1; j < netNum && netHash[byHash[j]] == netHash[netA]; ++j)
+        {
+            int netB = byHash[j];
+            if (!merged[netB] && netStart[netA + 1] - netStart[netA] == netStart[netB + 1] - netStart[netB] &&
+                equal(netPins.begin() + netStart[netA], netPins.begin() + netStart[netA + 1], netPins.begin() + netStart[netB]))
+            {
+                netWeight[netA] += netWeight[netB];
+                merged[netB] = true;
+            }
+        }
+    }
+
+    for (int i = 0; i < netNum; ++i)
+    {
+        if (merged[i])
+        {
+            continue;
+        }
+        for (int j = netStart[i]; j < netStart[i + 1]; ++j)
+        {
+            coarse.addPin(netPins[j]);
+        }
+        coarse.closeNet(netWeight[i]);
+    }
+    coarse.buildCellNets();
+}
+
+void MultilevelPartitioner::partition()
+{
+    const Hypergraph &finest = _partitioner.getGraph();
+    double bFactor = _partitioner.getBFactor(), targetRatio = _partitioner.getTargetRatio();
+    int totalWeight = finest.getTotalCellWeight();
+
+    // keep coarse cells light enough for the initial split to land inside the balance window
+    _maxClusterWeight = max(1, (int)min(1.5 * totalWeight / _coarsestSize, bFactor * totalWeight * min(targetRatio, 1 - targetRatio)));
+    _levelCellNum.assign(1, finest.getCellNum());
+
+    // coarsening phase
+    vector<unique_ptr<Hypergraph> > levels;
+    vector<vector<int> > fineToCoarse;
+    const Hypergraph *fine = &finest;
+    while (fine->getCellNum() > _coarsestSize)
+    {
+        vector<int> cellMap;
+        int coarseCellNum = this->matchCells(*fine, cellMap);
+        if (coarseCellNum > _minReduction * fine->getCellNum())
+        {
+            break;
+        }
+        levels.push_back(unique_ptr<Hypergraph>(new Hypergraph()));
+        this->contract(*fine, cellMap, coarseCellNum, *levels.back());
+        fineToCoarse.push_back(cellMap);
+        _levelCellNum.push_back(coarseCellNum);
+        fine = levels.back().get();
+    }
+
+    if (levels.empty())
+    {
+        _partitioner.initPartition();
+        if (_verbose)
+        {
+            cout << "Initial cutsize: " << _partitioner.getCutSize() << endl;
+        }
+        _partitioner.refine();
+        return;
+    }
+
+    // initial partitioning on the coarsest level
+    vector<char> cellPart;
+    {
+        Partitioner coarsest(*levels.back(), bFactor);
+        coarsest.setTargetRatio(targetRatio);
+        coarsest.setStopPolicy(_partitioner.getStopPolicy());
+        coarsest.setBucketPolicy(_partitioner.getBucketPolicy());
+        coarsest.setLargeNetSize(_partitioner.getLargeNetSize());
+        coarsest.setGrowInit(_partitioner.isGrowInit());
+        coarsest.initPartition();
+        if (_verbose)
+        {
+            cout << "Initial cutsize: " << coarsest.getCutSize() << " (level " << levels.size() << ", " << coarsest.getCellNum() << " cells)" << endl;
+        }
+        coarsest.refine();
+        cellPart.resize(coarsest.getCellNum());
+        for (int i = 0; i < coarsest.getCellNum(); ++i)
+        {
+            cellPart[i] = coarsest.getCellPart(i);
+        }
+    }
+
+    // uncoarsening phase, project the partition and refine it level by level
+    for (int level = levels.size() - 1; level >= 0; --level)
+    {
+        const vector<int> &cellMap = fineToCoarse[level];
+        vector<char> finePart(cellMap.size());
+        for (size_t i = 0; i < cellMap.size(); ++i)
+        {
+            finePart[i] = cellPart[cellMap[i]];
+        }
+
+        if (level == 0)
+        {
+            _partitioner.initPartition(finePart);
+            _partitioner.refine();
+        }
+        else
+        {
+            Partitioner refiner(*levels[level - 1], bFactor);
+            refiner.setTargetRatio(targetRatio);
+            refiner.setStopPolicy(_partitioner.getStopPolicy());
+            refiner.setBucketPolicy(_partitioner.getBucketPolicy());
+            refiner.setLargeNetSize(_partitioner.getLargeNetSize());
+            refiner.initPartition(finePart);
+            refiner.refine();
+            for (int i = 0; i < refiner.getCellNum(); ++i)
+            {
+                finePart[i] = refiner.getCellPart(i);
+            }
+        }
+        levels[level].reset();
+        cellPart.swap(finePart);
+    }
+}
@@ -0,0 +1,47 @@
+#ifndef MULTILEVEL_H
+#define MULTILEVEL_H
+
+#include <vector>
+#include "hypergraph.h"
+#include "partitioner.h"
+using namespace std;
+
+class MultilevelPartitioner
+{
+public:
+    // constructor and destructor
+    MultilevelPartitioner(Partitioner& partitioner) :
+        _partitioner(partitioner), _coarsestSize(400), _minReduction(0.9), _largeNetSize(1000),
+        _maxClusterWeight(1), _seed(0), _verbose(true) { }
+    ~MultilevelPartitioner() { }
+
+    // basic access methods
+    int getLevelNum() const         { return (int)_levelCellNum.size(); }
+    int getLevelCellNum(int level) const { return _levelCellNum[level]; }
+
+    // set functions
+    void setCoarsestSize(const int coarsestSize)    { _coarsestSize = coarsestSize; }
+    void setSeed(const unsigned seed)               { _seed = seed; }
+    void setVerbose(const bool verbose)             { _verbose = verbose; }
+
+    // modify method
+    void partition();
+
+    // merge the cells of each cluster into one coarse cell, also used by the memetic recombination
+    static void contract(const Hypergraph& fine, const vector<int>& fineToCoarse, int coarseCellNum, Hypergraph& coarse);
+
+private:
+    Partitioner&        _partitioner;       // partitioner of the finest level
+    int                 _coarsestSize;      // stop coarsening once a level has at most this many cells
+    double              _minReduction;      // stop coarsening once a level keeps more than this ratio of cells
+    int                 _largeNetSize;      // nets larger than this are ignored when rating neighbors
+    int                 _maxClusterWeight;  // upper bound of the weight of a coarse cell
+    unsigned            _seed;              // seed of the cell visiting order
+    bool                _verbose;           // whether to report the coarsest level
+    vector<int>         _levelCellNum;      // cell number of each level, finest first
+
+    // coarsening
+    int matchCells(const Hypergraph& fine, vector<int>& fineToCoarse) const;
+};
+
+#endif  // MULTILEVEL_H
@@ -0,0 +1,78 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include "partitioner.h"
+#include "multilevel.h"
+#include "multistart.h"
+#include "threadpool.h"
+using namespace std;
+
+void MultiStartPartitioner::runStart(int start, vector<char> &cellPart)
+{
+    // every start owns its partitioner workspace, only the hypergraph is shared
+    Partitioner worker(_partitioner.getGraph(), _partitioner.getBFactor());
+    worker.setStopPolicy(_partitioner.getStopPolicy());
+    worker.setBucketPolicy(_partitioner.getBucketPolicy());
+    worker.setLargeNetSize(_partitioner.getLargeNetSize());
+    worker.setGrowInit(_partitioner.isGrowInit());
+    if (_multilevel)
+    {
+        MultilevelPartitioner multilevelPartitioner(worker);
+        multilevelPartitioner.setSeed(start);
+        multilevelPartitioner.setVerbose(false);
+        multilevelPartitioner.partition();
+    }
+    else
+    {
+        // start 0 keeps the deterministic initial partition
+        if (start == 0)
+        {
+            worker.initPartition();
+        }
+        else
+        {
+            worker.initPerturbedPartition(start);
+        }
+        worker.refine();
+    }
+
+    cellPart.resize(worker.getCellNum());
+    for (int i = 0; i < worker.getCellNum(); ++i)
+    {
+        cellPart[i] = worker.getCellPart(i);
+    }
+    _startCutSize[start] = worker.isBalanced() ? worker.getCutSize() : -1;
+}
+
+void MultiStartPartitioner::partition()
+{
+    vector<vector<char> > startPart(_startNum);
+    _startCutSize.assign(_startNum, -1);
+    {
+        ThreadPool pool(_threadNum > 0 ? min(_threadNum, _startNum) : _threadNum);
+        for (int i = 0; i < _startNum; ++i)
+        {
+            pool.submit([this, i, &startPart]
+                        { this->runStart(i, startPart[i]); });
+        }
+        pool.wait();
+    }
+
+    // keep the minimum cut among the balanced solutions
+    _bestStart = -1;
+    for (int i = 0; i < _startNum; ++i)
+    {
+        cout << "Start " << i << " cutsize: " << _startCutSize[i] << endl;
+        if (_startCutSize[i] >= 0 && (_bestStart == -1 || _startCutSize[i] < _startCutSize[_bestStart]))
+        {
+            _bestStart = i;
+        }
+    }
+    if (_bestStart == -1)
+    {
+        cerr << "No balanced solution among " << _startNum << " starts." << endl;
+        _bestStart = 0;
+    }
+    cout << "Best start: " << _bestStart << endl;
+    _partitioner.initPartition(startPart[_bestStart]);
+}
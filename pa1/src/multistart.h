@@ -0,0 +1,38 @@
+#ifndef MULTISTART_H
+#define MULTISTART_H
+
+#include <vector>
+#include "partitioner.h"
+using namespace std;
+
+class MultiStartPartitioner
+{
+public:
+    // constructor and destructor, threadNum <= 0 means one thread per hardware thread
+    MultiStartPartitioner(Partitioner& partitioner, int startNum, int threadNum) :
+        _partitioner(partitioner), _startNum(startNum), _threadNum(threadNum), _multilevel(false), _bestStart(-1) { }
+    ~MultiStartPartitioner() { }
+
+    // basic access methods
+    int getStartNum() const                 { return _startNum; }
+    int getBestStart() const                { return _bestStart; }
+    int getStartCutSize(int start) const    { return _startCutSize[start]; }
+
+    // set functions
+    void setMultilevel(const bool multilevel)   { _multilevel = multilevel; }
+
+    // modify method
+    void partition();
+
+private:
+    Partitioner&        _partitioner;   // partitioner which receives the best solution
+    int                 _startNum;      // number of independent starts
+    int                 _threadNum;     // number of worker threads
+    bool                _multilevel;    // whether each start runs the multilevel flow
+    int                 _bestStart;     // start with the minimum balanced cut
+    vector<int>         _startCutSize;  // cut size of each start, -1 if unbalanced
+
+    void runStart(int start, vector<char>& cellPart);
+};
+
+#endif  // MULTISTART_H
@@ -0,0 +1,116 @@
+#include <vector>
+#include <cstring>
+#include "nametable.h"
+using namespace std;
+
+unsigned NameTable::hash(const char *begin, const char *end)
+{
+    // FNV-1a
+    unsigned h = 2166136261u;
+    for (const char *c = begin; c != end; ++c)
+    {
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    }
+    return h;
+}
+
+const char *NameTable::store(const char *begin, const char *end)
+{
+    // copy the name into the arena, a new block is opened when the last one is full
+    size_t length = end - begin;
+    if (_blockUsed + length + 1 > _blockSize)
+    {
+        _blockSize = length + 1 > (1 << 20) ? length + 1 : (1 << 20);
+        _blocks.push_back(new char[_blockSize]);
+        _blockUsed = 0;
+    }
+    char *name = _blocks.back() + _blockUsed;
+    memcpy(name, begin, length);
+    name[length] = '\0';
+    _blockUsed += length + 1;
+    return name;
+}
+
+int NameTable::intern(const char *begin, const char *end, bool &inserted)
+{
+    size_t length = end - begin;
+    unsigned h = hash(begin, end);
+    size_t mask = _slots.size() - 1;
+    for (size_t slot = h & mask;; slot = (slot + 1) & mask)
+    {
+        int id = _slots[slot].id;
+        if (id == -1)
+        {
+            // a newly seen name
+            id = _names.size();
+            _names.push_back(store(begin, end));
+            _slots[slot].name = _names.back();
+            _slots[slot].hash = h;
+            _slots[slot].id = id;
+            if (2 * _names.size() > _slots.size())
+            {
+                rehash();
+            }
+            inserted = true;
+            return id;
+        }
+        const char *name = _slots[slot].name;
+        if (_slots[slot].hash == h && strncmp(name, begin, length) == 0 && name[length] == '\0')
+        {
+            inserted = false;
+            return id;
+        }
+    }
+}
+
+int NameTable::find(const char *begin, const char *end) const
+{
+    size_t length = end - begin;
+    unsigned h = hash(begin, end);
+    size_t mask = _slots.size() - 1;
+    for (size_t slot = h & mask; _slots[slot].id != -1; slot = (slot + 1) & mask)
+    {
+        const char *name = _slots[slot].name;
+        if (_slots[slot].hash == h && strncmp(name, begin, length) == 0 && name[length] == '\0')
+        {
+            return _slots[slot].id;
+        }
+    }
+    return -1;
+}
+
+void NameTable::rehash()
+{
+    // double the table and reinsert every slot by its cached hash
+    vector<Slot> oldSlots(2 * _slots.size());
+    oldSlots.swap(_slots);
+    size_t mask = _slots.size() - 1;
+    for (size_t i = 0; i < oldSlots.size(); ++i)
+    {
+        if (oldSlots[i].id == -1)
+        {
+            continue;
+        }
+        size_t slot = oldSlots[i].hash & mask;
+        while (_slots[slot].id != -1)
+        {
+            slot = (slot + 1) & mask;
+        }
+        _slots[slot] = oldSlots[i];
+    }
+    return;
+}
+
+void NameTable::clear()
+{
+    for (size_t i = 0; i < _blocks.size(); ++i)
+    {
+        delete[] _blocks[i];
+    }
+    _blocks.clear();
+    _blockUsed = 0;
+    _blockSize = 0;
+    _names.clear();
+    _slots.assign(1024, Slot());
+    return;
+}
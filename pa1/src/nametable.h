@@ -0,0 +1,51 @@
+#ifndef NAMETABLE_H
+#define NAMETABLE_H
+
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+class NameTable
+{
+public:
+    // constructor and destructor
+    NameTable() :
+        _blockUsed(0), _blockSize(0) {
+        _slots.assign(1024, Slot());
+    }
+    ~NameTable() {
+        clear();
+    }
+
+    // basic access methods
+    int getNameNum() const                  { return (int)_names.size(); }
+    const char* getName(int id) const       { return _names[id]; }
+
+    // id of a name, -1 if it was never interned
+    int find(const char* begin, const char* end) const;
+
+    // modify methods
+    int intern(const char* begin, const char* end, bool& inserted);
+    const char* store(const char* begin, const char* end);
+    void clear();
+
+private:
+    struct Slot
+    {
+        Slot() : name(NULL), hash(0), id(-1) { }
+        const char* name;   // interned name in the arena
+        unsigned    hash;   // hash of the name, checked before touching the arena
+        int         id;     // id of the name, -1 if empty
+    };
+
+    vector<char*>       _blocks;        // arena blocks, never moved once allocated
+    size_t              _blockUsed;     // bytes used in the last block
+    size_t              _blockSize;     // capacity of the last block
+    vector<const char*> _names;         // interned names by id, NUL-terminated in the arena
+    vector<Slot>        _slots;         // open addressing table of ids
+
+    static unsigned hash(const char* begin, const char* end);
+    void rehash();
+};
+
+#endif  // NAMETABLE_H
@@ -0,0 +1,322 @@
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include "hypergraph.h"
+#include "partitioner.h"
+#include "parallelfm.h"
+#include "threadpool.h"
+using namespace std;
+
+int ParallelFMRefiner::computeGain(int cellId) const
+{
+    // exact gain on the shared partition
+    const Hypergraph &graph = _partitioner.getGraph();
+    int part = _cellPart[cellId], gain = 0;
+    for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+    {
+        if (_netPartCount[2 * *net + part] == 1)
+        {
+            gain += graph.getNetWeight(*net);
+        }
+        if (_netPartCount[2 * *net + !part] == 0)
+        {
+            gain -= graph.getNetWeight(*net);
+        }
+    }
+    return gain;
+}
+
+int ParallelFMRefiner::computeGain(int cellId, const LocalView &view) const
+{
+    // gain on the shared partition with the moves of a search applied on top
+    const Hypergraph &graph = _partitioner.getGraph();
+    int part = _cellPart[cellId] ^ (view.cellState[cellId] == 2), gain = 0;
+    for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+    {
+        int count[2] = {_netPartCount[2 * *net] + view.netDelta[*net], _netPartCount[2 * *net + 1] - view.netDelta[*net]};
+        if (count[part] == 1)
+        {
+            gain += graph.getNetWeight(*net);
+        }
+        if (count[!part] == 0)
+        {
+            gain -= graph.getNetWeight(*net);
+        }
+    }
+    return gain;
+}
+
+bool ParallelFMRefiner::claimCell(int cellId, int searchId)
+{
+    int freeOwner = 0;
+    return _cellOwner[cellId].load(memory_order_relaxed) == 0 &&
+           _cellOwner[cellId].compare_exchange_strong(freeOwner, searchId + 1, memory_order_relaxed);
+}
+
+bool ParallelFMRefiner::search(int searchId, LocalView &view, vector<int> &moves)
+{
+    // the shared partition is only read, a cell is claimed by the first search which moves it;
+    // returns whether a claim or the balance turned a cell down, so the search may find more next round
+    const Hypergraph &graph = _partitioner.getGraph();
+    for (size_t i = 0; i < view.queuedCells.size(); ++i)
+    {
+        view.cellState[view.queuedCells[i]] = 0;
+    }
+    for (size_t i = 0; i < view.touchedNets.size(); ++i)
+    {
+        view.netDelta[view.touchedNets[i]] = 0;
+    }
+    view.queuedCells.clear();
+    view.touchedNets.clear();
+    view.queue.clear();
+    view.sizeDelta = 0;
+    moves.clear();
+
+    // max gain first, ties to the smaller cell id; queued gains come from the snapshot and are checked when popped
+    for (int i = searchId * _seedNum; i < min((searchId + 1) * _seedNum, (int)_seeds.size()); ++i)
+    {
+        if (_cellOwner[_seeds[i]].load(memory_order_relaxed) == 0)
+        {
+            view.cellState[_seeds[i]] = 1;
+            view.queuedCells.push_back(_seeds[i]);
+            view.queue.push_back(make_pair(_cellGain[_seeds[i]], -_seeds[i]));
+            push_heap(view.queue.begin(), view.queue.end());
+        }
+    }
+    int accGain = 0, bestGain = 0, bestMoveNum = 0;
+    bool blocked = false;
+    while (!view.queue.empty() && (int)moves.size() < _maxSearchMoveNum && (int)moves.size() - bestMoveNum < _searchWindow)
+    {
+        pop_heap(view.queue.begin(), view.queue.end());
+        int gain = view.queue.back().first, cellId = -view.queue.back().second;
+        view.queue.pop_back();
+        int exactGain = this->computeGain(cellId, view);
+        if (exactGain != gain)
+        {
+            view.queue.push_back(make_pair(exactGain, -cellId));
+            push_heap(view.queue.begin(), view.queue.end());
+            continue;
+        }
+
+        // keep the snapshot sizes plus the moves of this search inside the balance bounds
+        int part = _cellPart[cellId], weight = graph.getCellWeight(cellId);
+        int partSize[2] = {_partSize[0] + view.sizeDelta, _partSize[1] - view.sizeDelta};
+        if (partSize[part] - weight < _lowerBound[part] || partSize[!part] + weight > _upperBound[!part] ||
+            !this->claimCell(cellId, searchId))
+        {
+            blocked = true;
+            continue;
+        }
+        view.cellState[cellId] = 2;
+        view.sizeDelta += part == 0 ? -weight : weight;
+        for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+        {
+            if (view.netDelta[*net] == 0)
+            {
+                view.touchedNets.push_back(*net);
+            }
+            view.netDelta[*net] += part == 0 ? -1 : 1;
+        }
+        moves.push_back(cellId);
+        accGain += gain;
+        if (accGain > bestGain)
+        {
+            bestGain = accGain;
+            bestMoveNum = moves.size();
+        }
+
+        // grow over the small nets of the moved cell into the cells no search has moved
+        for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+        {
+            if (graph.getNetSize(*net) > _largeNetSize)
+            {
+                continue;
+            }
+            for (const int *cell = graph.netCellBegin(*net); cell != graph.netCellEnd(*net); ++cell)
+            {
+                if (view.cellState[*cell] == 0 && _cellOwner[*cell].load(memory_order_relaxed) == 0)
+                {
+                    view.cellState[*cell] = 1;
+                    view.queuedCells.push_back(*cell);
+                    view.queue.push_back(make_pair(_cellGain[*cell], -*cell));
+                    push_heap(view.queue.begin(), view.queue.end());
+                }
+            }
+        }
+    }
+
+    // keep the best prefix, release the cells moved after it for the later searches
+    for (size_t i = bestMoveNum; i < moves.size(); ++i)
+    {
+        _cellOwner[moves[i]].store(0, memory_order_relaxed);
+    }
+    moves.resize(bestMoveNum);
+    return blocked;
+}
+
+void ParallelFMRefiner::moveCell(int cellId)
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    bool fromPart = _cellPart[cellId];
+    _cellPart[cellId] = !fromPart;
+    _partSize[fromPart] -= graph.getCellWeight(cellId);
+    _partSize[!fromPart] += graph.getCellWeight(cellId);
+    for (const int *net = graph.cellNetBegin(cellId); net != graph.cellNetEnd(cellId); ++net)
+    {
+        _netPartCount[2 * *net + fromPart]--;
+        _netPartCount[2 * *net + !fromPart]++;
+    }
+}
+
+void ParallelFMRefiner::refine()
+{
+    const Hypergraph &graph = _partitioner.getGraph();
+    int cellNum = graph.getCellNum();
+    _cellPart.resize(cellNum);
+    _netPartCount.resize(2 * graph.getNetNum());
+    for (int i = 0; i < cellNum; ++i)
+    {
+        _cellPart[i] = _partitioner.getCellPart(i);
+    }
+    for (int i = 0; i < graph.getNetNum(); ++i)
+    {
+        _netPartCount[2 * i] = _partitioner.getNetPartCount(i, 0);
+        _netPartCount[2 * i + 1] = _partitioner.getNetPartCount(i, 1);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        _partSize[i] = _partitioner.getPartSize(i);
+        _lowerBound[i] = _partitioner.getLowerBound(i);
+        _upperBound[i] = _partitioner.getUpperBound(i);
+    }
+
+    ThreadPool pool(_threadNum);
+    int taskNum = pool.getThreadNum();
+    _cellGain.resize(cellNum);
+    vector<atomic<int> >(cellNum).swap(_cellOwner);
+    vector<char> roundMoved(cellNum, false), active(cellNum, true);
+    vector<int> journal;
+    _moveNum = 0;
+    for (_roundNum = 0; _roundNum < _maxRoundNum;)
+    {
+        // snapshot gains of the partition at the start of the round
+        for (int i = 0; i < taskNum; ++i)
+        {
+            int beginCell = (long long)cellNum * i / taskNum, endCell = (long long)cellNum * (i + 1) / taskNum;
+            pool.submit([this, beginCell, endCell]
+                        {
+                            for (int j = beginCell; j < endCell; ++j)
+                            {
+                                _cellGain[j] = this->computeGain(j);
+                                _cellOwner[j].store(0, memory_order_relaxed);
+                            }
+                        });
+        }
+        pool.wait();
+
+        // seed from the cells of the cut nets with a non-negative gain, after the first round only around the kept
+        // moves of the last one and from the searches which were turned down, a search elsewhere would find nothing again
+        _seeds.clear();
+        for (int i = 0; i < cellNum; ++i)
+        {
+            if (!active[i] || _cellGain[i] < 0)
+            {
+                continue;
+            }
+            for (const int *net = graph.cellNetBegin(i); net != graph.cellNetEnd(i); ++net)
+            {
+                if (_netPartCount[2 * *net] > 0 && _netPartCount[2 * *net + 1] > 0)
+                {
+                    _seeds.push_back(i);
+                    break;
+                }
+            }
+        }
+        if (_seeds.empty())
+        {
+            break;
+        }
+        ++_roundNum;
+
+        // localized searches, every worker reuses one view for a strided share of the searches
+        int searchNum = (_seeds.size() + _seedNum - 1) / _seedNum;
+        vector<vector<int> > searchMoves(searchNum);
+        vector<char> searchBlocked(searchNum);
+        for (int i = 0; i < taskNum; ++i)
+        {
+            pool.submit([this, i, taskNum, searchNum, &searchMoves, &searchBlocked]
+                        {
+                            LocalView view;
+                            view.cellState.assign(_cellPart.size(), 0);
+                            view.netDelta.assign(_netPartCount.size() / 2, 0);
+                            for (int j = i; j < searchNum; j += taskNum)
+                            {
+                                searchBlocked[j] = this->search(j, view, searchMoves[j]);
+                            }
+                        });
+        }
+        pool.wait();
+
+        // replay the sequences in search order with exact gains, a cell moves at most once a round,
+        // then roll back to the best prefix of everything applied
+        int accGain = 0, bestGain = 0, bestMoveNum = 0;
+        journal.clear();
+        for (int i = 0; i < searchNum; ++i)
+        {
+            for (size_t j = 0; j < searchMoves[i].size(); ++j)
+            {
+                int cellId = searchMoves[i][j], part = _cellPart[cellId], weight = graph.getCellWeight(cellId);
+                if (roundMoved[cellId] || _partSize[part] - weight < _lowerBound[part] || _partSize[!part] + weight > _upperBound[!part])
+                {
+                    continue;
+                }
+                accGain += this->computeGain(cellId);
+                this->moveCell(cellId);
+                roundMoved[cellId] = true;
+                journal.push_back(cellId);
+                if (accGain > bestGain)
+                {
+                    bestGain = accGain;
+                    bestMoveNum = journal.size();
+                }
+            }
+        }
+        for (int i = journal.size() - 1; i >= 0; --i)
+        {
+            if (i >= bestMoveNum)
+            {
+                this->moveCell(journal[i]);
+            }
+            roundMoved[journal[i]] = false;
+        }
+        _moveNum += bestMoveNum;
+        fill(active.begin(), active.end(), false);
+        for (int i = 0; i < searchNum; ++i)
+        {
+            for (int j = i * _seedNum; searchBlocked[i] && j < min((i + 1) * _seedNum, (int)_seeds.size()); ++j)
+            {
+                active[_seeds[j]] = true;
+            }
+        }
+        for (int i = 0; i < bestMoveNum; ++i)
+        {
+            for (const int *net = graph.cellNetBegin(journal[i]); net != graph.cellNetEnd(journal[i]); ++net)
+            {
+                if (graph.getNetSize(*net) > _largeNetSize)
+                {
+                    continue;
+                }
+                for (const int *cell = graph.netCellBegin(*net); cell != graph.netCellEnd(*net); ++cell)
+                {
+                    active[*cell] = true;
+                }
+            }
+        }
+        if (bestGain == 0)
+        {
+            break;
+        }
+    }
+    _partitioner.initPartition(_cellPart);
+}
@@ -0,0 +1,70 @@
+#ifndef PARALLELFM_H
+#define PARALLELFM_H
+
+#include <vector>
+#include <atomic>
+#include "hypergraph.h"
+#include "partitioner.h"
+using namespace std;
+
+// parallel F-M refinement by localized searches, every search grows from a few boundary seeds over a read-only
+// snapshot of the partition and claims the cells it moves, then the found move sequences are replayed one after
+// another with exact gains
+class ParallelFMRefiner
+{
+public:
+    // constructor and destructor, threadNum <= 0 means one thread per hardware thread
+    ParallelFMRefiner(Partitioner& partitioner, int threadNum) :
+        _partitioner(partitioner), _threadNum(threadNum), _seedNum(4), _maxSearchMoveNum(200), _searchWindow(5),
+        _largeNetSize(50), _maxRoundNum(16), _roundNum(0), _moveNum(0) { }
+    ~ParallelFMRefiner() { }
+
+    // basic access methods
+    int getRoundNum() const         { return _roundNum; }
+    int getMoveNum() const          { return _moveNum; }
+
+    // set functions
+    void setMaxRoundNum(const int maxRoundNum)  { _maxRoundNum = maxRoundNum; }
+
+    // modify method, refine the current partition of the partitioner
+    void refine();
+
+private:
+    // moves and net count changes of one search on top of the shared partition, dense per worker and
+    // reset through the touched lists, so starting a search costs only what the previous one touched
+    struct LocalView
+    {
+        vector<char>                cellState;      // whether each cell is untouched (0), queued (1) or moved (2)
+        vector<int>                 netDelta;       // change of the cell number of each net in A, B changes the other way
+        vector<int>                 queuedCells;    // cells queued by the search, moved or not
+        vector<int>                 touchedNets;    // nets with a (possibly zero again) delta
+        vector<pair<int, int> >     queue;          // max heap of (gain, -cell id)
+        int                         sizeDelta;      // change of the size of partition A
+    };
+
+    Partitioner&        _partitioner;       // partitioner which provides and receives the partition
+    int                 _threadNum;         // number of worker threads
+    int                 _seedNum;           // boundary cells a search starts from
+    int                 _maxSearchMoveNum;  // upper bound of the moves of a search
+    int                 _searchWindow;      // a search stops after this many moves without a new best prefix
+    int                 _largeNetSize;      // a search does not grow over nets larger than this
+    int                 _maxRoundNum;       // upper bound of the rounds
+    int                 _roundNum;          // number of rounds run
+    int                 _moveNum;           // number of kept moves over all rounds
+    vector<char>        _cellPart;          // partition of each cell (0-A, 1-B)
+    vector<int>         _netPartCount;      // cell number of each net in A(2 * id) and B(2 * id + 1)
+    int                 _partSize[2];       // size (cell weight) of partition A(0) and B(1)
+    double              _lowerBound[2];     // lower bound of the size of each partition
+    double              _upperBound[2];     // upper bound of the size of each partition
+    vector<int>         _seeds;             // non-negative gain boundary cells of the current round
+    vector<int>         _cellGain;          // gain of each cell on the partition at the start of the round
+    vector<atomic<int> > _cellOwner;        // search (id + 1) which holds each cell in this round, 0 if free
+
+    int computeGain(int cellId) const;
+    int computeGain(int cellId, const LocalView& view) const;
+    bool claimCell(int cellId, int searchId);
+    bool search(int searchId, LocalView& view, vector<int>& moves);
+    void moveCell(int cellId);
+};
+
+#endif  // PARALLELFM_H
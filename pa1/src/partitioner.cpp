@@ -5,234 +5,540 @@
 #include <cassert>
 #include <vector>
 #include <cmath>
-#include <unordered_map>
-#include <map>
+#include <cstring>
 #include <algorithm>
+#include <numeric>
+#include <random>
+#include <queue>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cell.h"
 #include "net.h"
 #include "partitioner.h"
+#include "snapshot.h"
+#include "threadpool.h"
 using namespace std;
 
+// pins below which the gain initialization stays on one thread
+const int PARALLEL_GAIN_PIN_NUM = 1 << 20;
+
 // added member functions
-void Partitioner::initPartition()
+void Partitioner::initSortingIndex()
 {
-    int maxPinNum = 0, partSize[2] = {0, 0};
-
-    // initialize partition with f(x)=max(netSize)+alpha*average(netSize)
-    vector<Cell *> cellArrayBySortingIndex;
+    // f(x)=max(netSize)+alpha*average(netSize)+beta*pinNum, also used to break gain ties
     for (int i = 0; i < _cellNum; ++i)
     {
         int maxNetSize = 0;
         int totalNetSize = 0;
-        Cell *pickedCell = _cellArray[i];
-        vector<int> pickedCellNetList = pickedCell->getNetList();
-        for (int j = 0; j < pickedCellNetList.size(); ++j)
+        Cell *pickedCell = &_cellArray[i];
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
         {
-            int netSize = _netArray[pickedCellNetList[j]]->getCellList().size();
+            int netSize = _graph.getNetSize(*net);
             totalNetSize += netSize;
             if (netSize > maxNetSize)
             {
                 maxNetSize = netSize;
             }
         }
-        pickedCell->setAvgNetSize(totalNetSize / pickedCellNetList.size());
+        pickedCell->setAvgNetSize(_graph.getCellDegree(i) > 0 ? totalNetSize / _graph.getCellDegree(i) : 0);
         pickedCell->setMaxNetSize(maxNetSize);
         pickedCell->setAlpha(1);
         pickedCell->setBeta(0.5);
-        pickedCell->setSortingIndex(pickedCell->getMaxNetSize() + pickedCell->getAlpha() * pickedCell->getAvgNetSize() + pickedCell->getBeta() * pickedCell->getPinNum());
-        cellArrayBySortingIndex.push_back(pickedCell);
+        pickedCell->setSortingIndex(pickedCell->getMaxNetSize() + pickedCell->getAlpha() * pickedCell->getAvgNetSize() + pickedCell->getBeta() * _graph.getCellDegree(i));
+    }
+}
+
+void Partitioner::initPartition()
+{
+    if (_growInit)
+    {
+        this->initGrowingPartition();
+        return;
     }
-    sort(cellArrayBySortingIndex.begin(), cellArrayBySortingIndex.end(), [](Cell *a, Cell *b)
-         { return a->getSortingIndex() < b->getSortingIndex(); });
 
-    // initialize partition with f(x)
-    int splitSize = _cellNum / 2;
-    double lowerBound = (1 - _bFactor) / 2 * _cellNum, upperBound = (1 + _bFactor) / 2 * _cellNum;
+    // initialize partition with f(x)=max(netSize)+alpha*average(netSize)
+    this->initSortingIndex();
+    vector<int> cellOrder(_cellNum);
+    iota(cellOrder.begin(), cellOrder.end(), 0);
+    sort(cellOrder.begin(), cellOrder.end(), [this](int a, int b)
+         { return _cellArray[a].getSortingIndex() < _cellArray[b].getSortingIndex(); });
+
+    // initialize partition with f(x), the target share of the total weight goes to A
+    int splitSize = _graph.getTotalCellWeight() * _targetRatio, partSize = 0;
+    vector<char> cellPart(_cellNum, 1);
     for (int i = 0; i < _cellNum; ++i)
     {
-        Cell *pickedCell = cellArrayBySortingIndex[i];
-        if (i < splitSize)
+        int cellId = cellOrder[i];
+        if (partSize < splitSize)
+        {
+            cellPart[cellId] = 0;
+            partSize += _graph.getCellWeight(cellId);
+        }
+    }
+    this->loadPartition(cellPart);
+}
+
+void Partitioner::initPerturbedPartition(unsigned seed)
+{
+    if (_growInit)
+    {
+        this->initGrowingPartition(seed);
+        return;
+    }
+
+    // jitter f(x) by up to 10% of its average so every seed splits a slightly different order
+    this->initSortingIndex();
+    double avgSortingIndex = 0;
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        avgSortingIndex += _cellArray[i].getSortingIndex();
+    }
+    avgSortingIndex /= _cellNum;
+
+    mt19937 rng(seed);
+    uniform_real_distribution<double> noise(0, 0.1 * avgSortingIndex);
+    vector<double> perturbedIndex(_cellNum);
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        perturbedIndex[i] = _cellArray[i].getSortingIndex() + noise(rng);
+    }
+    vector<int> cellOrder(_cellNum);
+    iota(cellOrder.begin(), cellOrder.end(), 0);
+    sort(cellOrder.begin(), cellOrder.end(), [&perturbedIndex](int a, int b)
+         { return perturbedIndex[a] < perturbedIndex[b]; });
+
+    int splitSize = _graph.getTotalCellWeight() * _targetRatio, partSize = 0;
+    vector<char> cellPart(_cellNum, 1);
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        if (partSize < splitSize)
+        {
+            cellPart[cellOrder[i]] = 0;
+            partSize += _graph.getCellWeight(cellOrder[i]);
+        }
+    }
+    this->loadPartition(cellPart);
+}
+
+int Partitioner::findPeripheralCell() const
+{
+    // sweep BFS over the hypergraph, restarting from the last reached cell while the depth still grows
+    vector<int> cellLevel(_cellNum), order(_cellNum);
+    vector<char> netVisited(_netNum);
+    int seed = 0, depth = -1;
+    for (int sweep = 0; sweep < 2; ++sweep)
+    {
+        fill(cellLevel.begin(), cellLevel.end(), -1);
+        fill(netVisited.begin(), netVisited.end(), false);
+        int head = 0, tail = 0;
+        order[tail++] = seed;
+        cellLevel[seed] = 0;
+        while (head < tail)
+        {
+            int cellId = order[head++];
+            for (const int *net = _graph.cellNetBegin(cellId); net != _graph.cellNetEnd(cellId); ++net)
+            {
+                if (netVisited[*net])
+                {
+                    continue;
+                }
+                netVisited[*net] = true;
+                for (const int *cell = _graph.netCellBegin(*net); cell != _graph.netCellEnd(*net); ++cell)
+                {
+                    if (cellLevel[*cell] == -1)
+                    {
+                        cellLevel[*cell] = cellLevel[cellId] + 1;
+                        order[tail++] = *cell;
+                    }
+                }
+            }
+        }
+        int lastCellId = order[tail - 1];
+        if (cellLevel[lastCellId] <= depth)
+        {
+            break;
+        }
+        depth = cellLevel[lastCellId];
+        seed = lastCellId;
+    }
+    return seed;
+}
+
+void Partitioner::initGrowingPartition(unsigned seed)
+{
+    // grow A from a pseudo-peripheral cell (seed 0) or a cell drawn by the seed, always taking the frontier
+    // cell whose move gains the most, until A holds its target share of the total weight
+    int splitSize = _graph.getTotalCellWeight() * _targetRatio, partSize = 0;
+    vector<char> cellPart(_cellNum, 1);
+    vector<int> netPartCount(2 * _netNum, 0);
+    vector<int> growGain(_cellNum, 0);
+    for (int i = 0; i < _netNum; ++i)
+    {
+        // with every cell in B a move cuts the net, unless the cell is its only pin
+        netPartCount[2 * i + 1] = _graph.getNetSize(i);
+        int delta = _graph.getNetSize(i) == 1 ? 0 : -_graph.getNetWeight(i);
+        for (const int *cell = _graph.netCellBegin(i); cell != _graph.netCellEnd(i); ++cell)
         {
-            pickedCell->setPart(0);
-            partSize[0]++;
-            _unlockNum[0]++;
-            vector<int> pickedCellNetList = pickedCell->getNetList();
-            for (int j = 0; j < pickedCellNetList.size(); ++j)
+            growGain[*cell] += delta;
+        }
+    }
+
+    // max heap of (gain, -cell id), gains only rise while A grows, so an entry below the current gain is stale
+    priority_queue<pair<int, int> > frontier;
+    if (_cellNum > 0)
+    {
+        int seedCell = seed == 0 ? this->findPeripheralCell() : mt19937(seed)() % _cellNum;
+        frontier.push(make_pair(growGain[seedCell], -seedCell));
+    }
+    int nextCellId = 0;
+    while (partSize < splitSize)
+    {
+        int cellId = -1;
+        while (!frontier.empty())
+        {
+            pair<int, int> top = frontier.top();
+            frontier.pop();
+            if (cellPart[-top.second] == 1 && top.first == growGain[-top.second])
             {
-                _netArray[pickedCellNetList[j]]->incPartCount(0);
+                cellId = -top.second;
+                break;
             }
         }
-        else
+        if (cellId == -1)
         {
-            pickedCell->setPart(1);
-            partSize[1]++;
-            _unlockNum[1]++;
-            vector<int> pickedCellNetList = pickedCell->getNetList();
-            for (int j = 0; j < pickedCellNetList.size(); ++j)
+            // A covers its whole component, continue from the next cell still in B
+            while (nextCellId < _cellNum && cellPart[nextCellId] == 0)
             {
-                _netArray[pickedCellNetList[j]]->incPartCount(1);
+                ++nextCellId;
             }
+            if (nextCellId == _cellNum)
+            {
+                break;
+            }
+            cellId = nextCellId;
+        }
+        cellPart[cellId] = 0;
+        partSize += _graph.getCellWeight(cellId);
+
+        // the first pin in A stops the net cutting for the rest, the last but one pin in B would uncut it
+        for (const int *net = _graph.cellNetBegin(cellId); net != _graph.cellNetEnd(cellId); ++net)
+        {
+            int countA = netPartCount[2 * *net]++, countB = netPartCount[2 * *net + 1]--;
+            int delta = ((countA == 0) + (countB == 2)) * _graph.getNetWeight(*net);
+            if (delta == 0)
+            {
+                continue;
+            }
+            for (const int *cell = _graph.netCellBegin(*net); cell != _graph.netCellEnd(*net); ++cell)
+            {
+                if (cellPart[*cell] == 1)
+                {
+                    growGain[*cell] += delta;
+                    frontier.push(make_pair(growGain[*cell], -*cell));
+                }
+            }
+        }
+    }
+    this->initPartition(cellPart);
+}
+
+void Partitioner::initPartition(const vector<char> &cellPart)
+{
+    // start from a given partition, e.g. one projected from a coarser level
+    this->initSortingIndex();
+    this->loadPartition(cellPart);
+}
+
+void Partitioner::loadPartition(const vector<char> &cellPart)
+{
+    int maxPinNum = 0;
+    _partSize[0] = 0;
+    _partSize[1] = 0;
+    _unlockNum[0] = 0;
+    _unlockNum[1] = 0;
+    fill(_netPartCount.begin(), _netPartCount.end(), 0);
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        bool part = cellPart[i];
+        int pinNum = 0;
+        _nodeArray[i].setPart(part);
+        _partSize[part] += _graph.getCellWeight(i);
+        _unlockNum[part]++;
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
+        {
+            _netPartCount[2 * *net + part]++;
+            pinNum += _graph.getNetWeight(*net);
         }
         // update maxPinNum
-        if (pickedCell->getPinNum() > maxPinNum)
+        if (pinNum > maxPinNum)
         {
-            maxPinNum = pickedCell->getPinNum();
+            maxPinNum = pinNum;
         }
     }
 
-    // initialize _maxPinNum
+    // initialize _maxPinNum, gain of a cell lies in [-Pmax, Pmax]
     _maxPinNum = maxPinNum;
 
-    // initialize _partSize and _cutSize
-    _partSize[0] = partSize[0];
-    _partSize[1] = partSize[1];
+    // initialize _cutSize
+    _cutSize = 0;
     for (int i = 0; i < _netNum; ++i)
     {
-        if (_netArray[i]->getPartCount(0) > 0 && _netArray[i]->getPartCount(1) > 0)
+        if (_netPartCount[2 * i] > 0 && _netPartCount[2 * i + 1] > 0)
         {
-            _cutSize++;
+            _cutSize += _graph.getNetWeight(i);
         }
     }
 }
 
-void Partitioner::addNode(Node *targetNode)
+template <class Policy>
+void Partitioner::addNode(GainBucket<Policy> &bucket, int cellId)
+{
+    // CLIP keys a cell by its gain change since the start of the pass
+    const Node &targetNode = _nodeArray[cellId];
+    int key = Policy::UPDATED_GAIN ? targetNode.getGain() - _passGain[cellId] : targetNode.getGain();
+    bucket.insert(cellId, targetNode.getPart(), key);
+    ++_pass.insertNum;
+}
+
+template <class Policy>
+void Partitioner::removeNode(GainBucket<Policy> &bucket, int cellId)
 {
-    // add targetNode to the linkedlist
-    Cell *addedCell = _cellArray[targetNode->getId()];
-    addedCell->setNode(targetNode);
-    map<int, Node *>::iterator it = _bList[addedCell->getPart()].find(addedCell->getGain());
+    const Node &targetNode = _nodeArray[cellId];
+    int key = Policy::UPDATED_GAIN ? targetNode.getGain() - _passGain[cellId] : targetNode.getGain();
+    bucket.remove(cellId, targetNode.getPart(), key);
+    ++_pass.removeNum;
+}
 
-    // if the gain is not in the map, create new
-    if (it == _bList[addedCell->getPart()].end())
+template <class Policy>
+void Partitioner::fillBucket(GainBucket<Policy> &bucket)
+{
+    // an updated gain lies in [-2 Pmax, 2 Pmax]
+    bucket.reset(Policy::UPDATED_GAIN ? 2 * _maxPinNum : _maxPinNum);
+    if (!Policy::UPDATED_GAIN)
     {
-        _bList[addedCell->getPart()].insert(pair<int, Node *>(addedCell->getGain(), targetNode));
+        for (int i = 0; i < _cellNum; ++i)
+        {
+            this->addNode(bucket, i);
+        }
+        return;
     }
-    else
+
+    // CLIP starts every cell in the zero bucket, inserting by ascending gain leaves the highest gain at the front
+    vector<int> gainStart(2 * _maxPinNum + 2, 0), cellOrder(_cellNum);
+    for (int i = 0; i < _cellNum; ++i)
     {
-        Node *firstNode = it->second;
-        _bList[addedCell->getPart()][addedCell->getGain()] = targetNode;
-        targetNode->setNext(firstNode);
-        firstNode->setPrev(targetNode);
+        gainStart[_nodeArray[i].getGain() + _maxPinNum + 1]++;
+    }
+    partial_sum(gainStart.begin(), gainStart.end(), gainStart.begin());
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        cellOrder[gainStart[_nodeArray[i].getGain() + _maxPinNum]++] = i;
+    }
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        this->addNode(bucket, cellOrder[i]);
     }
 }
 
-void Partitioner::removeNode(Node *targetNode)
+void Partitioner::initGain()
 {
-    Cell *removedCell = _cellArray[targetNode->getId()];
-    Node *prevNode = targetNode->getPrev();
-    Node *nextNode = targetNode->getNext();
-
-    // remove targetNode from the linkedlist
-    if (prevNode != NULL && nextNode != NULL)
+    // start from the gains carryGain patched after the last rollback if it did
+    if (_gainCarried)
     {
-        // if targetNode is not the first node nor the last node
-        prevNode->setNext(nextNode);
-        nextNode->setPrev(prevNode);
-        targetNode->setPrev(NULL);
-        targetNode->setNext(NULL);
+        for (int i = 0; i < _cellNum; ++i)
+        {
+            _nodeArray[i].setGain(_passGain[i]);
+        }
+        return;
     }
-    else if (prevNode == NULL && nextNode != NULL)
+
+    // initialize gain of each cell, with workers every cell sums its own nets so the cell ranges need no locking
+    if (_gainPool != NULL)
     {
-        // if targetNode is the first node
-        _bList[removedCell->getPart()][removedCell->getGain()] = nextNode;
-        nextNode->setPrev(NULL);
-        targetNode->setPrev(NULL);
-        targetNode->setNext(NULL);
+        int taskNum = _gainPool->getThreadNum();
+        for (int i = 0; i < taskNum; ++i)
+        {
+            int beginCell = (long long)_cellNum * i / taskNum, endCell = (long long)_cellNum * (i + 1) / taskNum;
+            _gainPool->submit([this, beginCell, endCell]
+                              { this->computeGain(beginCell, endCell); });
+        }
+        _gainPool->wait();
     }
-    else if (prevNode != NULL && nextNode == NULL)
+    else
     {
-        // if targetNode is the last node
-        prevNode->setNext(NULL);
-        targetNode->setPrev(NULL);
-        targetNode->setNext(NULL);
+        // a single thread is faster net by net, each net reads its counts and weight once
+        for (int i = 0; i < _netNum; ++i)
+        {
+            if (_netLarge[i])
+            {
+                continue;
+            }
+            for (const int *cell = _graph.netCellBegin(i); cell != _graph.netCellEnd(i); ++cell)
+            {
+                int part = _nodeArray[*cell].getPart();
+                int fromSide = _netPartCount[2 * i + part], toSide = _netPartCount[2 * i + !part];
+                if (fromSide == 1)
+                {
+                    _nodeArray[*cell].addGain(_graph.getNetWeight(i));
+                }
+                if (toSide == 0)
+                {
+                    _nodeArray[*cell].addGain(-_graph.getNetWeight(i));
+                }
+            }
+        }
     }
-    else
+
+    // the gains of the pass, the buckets key CLIP cells by the change from them
+    for (int i = 0; i < _cellNum; ++i)
     {
-        // if targetNode is the only node
-        _bList[removedCell->getPart()].erase(removedCell->getGain());
-        targetNode->setPrev(NULL);
-        targetNode->setNext(NULL);
+        _passGain[i] = _nodeArray[i].getGain();
     }
 }
 
-void Partitioner::initGain()
+void Partitioner::computeGain(int beginCell, int endCell)
 {
-    // initialize gain of each cell
-    for (int i = 0; i < _netNum; ++i)
+    // sum the gain of each cell over its own nets, the same for any split of the cells
+    for (int i = beginCell; i < endCell; ++i)
     {
-        Net *pickedNet = _netArray[i];
-        vector<int> pickedCellList = pickedNet->getCellList();
-        for (int j = 0; j < pickedCellList.size(); ++j)
+        int part = _nodeArray[i].getPart(), gain = 0;
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
         {
-            Cell *pickedCell = _cellArray[pickedCellList[j]];
-            int fromSide = -1, toside = -1;
-            if (pickedCell->getPart() == 0)
+            if (_netLarge[*net])
             {
-                fromSide = pickedNet->getPartCount(0);
-                toside = pickedNet->getPartCount(1);
-            }
-            else
-            {
-                fromSide = pickedNet->getPartCount(1);
-                toside = pickedNet->getPartCount(0);
+                continue;
             }
+            int fromSide = _netPartCount[2 * *net + part], toSide = _netPartCount[2 * *net + !part];
             if (fromSide == 1)
             {
-                pickedCell->incGain();
+                gain += _graph.getNetWeight(*net);
             }
-            if (toside == 0)
+            if (toSide == 0)
             {
-                pickedCell->decGain();
+                gain -= _graph.getNetWeight(*net);
             }
         }
+        _nodeArray[i].setGain(gain);
     }
+}
 
-    // blist initialize
-    for (int i = 0; i < _cellNum; ++i)
+void Partitioner::carryGain()
+{
+    // patching costs about four times a full recomputation per kept cell,
+    // so only a short kept prefix is worth carrying over
+    _gainCarried = _bestMoveNum < _cellNum / 16;
+    if (!_gainCarried)
+    {
+        return;
+    }
+
+    // after the rollback only the nets of the kept cells differ from the start of the pass
+    for (int i = 0; i < _bestMoveNum; ++i)
+    {
+        _cellKept[_moveStack[i]] = true;
+    }
+    for (int i = 0; i < _bestMoveNum; ++i)
     {
-        this->addNode(_cellArray[i]->getNode());
+        int keptCellId = _moveStack[i];
+        for (const int *net = _graph.cellNetBegin(keptCellId); net != _graph.cellNetEnd(keptCellId); ++net)
+        {
+            if (_netStamp[*net] == _iterNum || _netLarge[*net])
+            {
+                continue;
+            }
+            _netStamp[*net] = _iterNum;
+
+            // each cell moves at most once a pass, so a kept cell started on the other side
+            const int *cellBegin = _graph.netCellBegin(*net), *cellEnd = _graph.netCellEnd(*net);
+            int count[2] = {_netPartCount[2 * *net], _netPartCount[2 * *net + 1]};
+            int oldCount[2] = {count[0], count[1]};
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
+            {
+                if (_cellKept[*cell])
+                {
+                    oldCount[(int)_nodeArray[*cell].getPart()]--;
+                    oldCount[!_nodeArray[*cell].getPart()]++;
+                }
+            }
+
+            // replace the old share of the net in the gain of every cell by the new one
+            int netWeight = _graph.getNetWeight(*net);
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
+            {
+                int part = _nodeArray[*cell].getPart(), oldPart = part ^ _cellKept[*cell];
+                int delta = (count[part] == 1) - (count[!part] == 0) - (oldCount[oldPart] == 1) + (oldCount[!oldPart] == 0);
+                _passGain[*cell] += delta * netWeight;
+            }
+        }
+    }
+    for (int i = 0; i < _bestMoveNum; ++i)
+    {
+        _cellKept[_moveStack[i]] = false;
     }
 }
 
-void Partitioner::updateGain()
+template <class Policy>
+void Partitioner::updateGain(GainBucket<Policy> &bucket)
 {
-    Cell *movedCell = _cellArray[_maxGainCell->getId()];
-    movedCell->lock();
-    vector<int> movedCellNetList = movedCell->getNetList();
-    int netSize = movedCellNetList.size();
+    int movedCellId = _maxGainCell;
+    bool movedPart = _nodeArray[movedCellId].getPart();
+    _nodeArray[movedCellId].setLock(true);
 
     // update the gain of all free cells in the net
-    for (int i = 0; i < netSize; ++i)
+    for (const int *net = _graph.cellNetBegin(movedCellId); net != _graph.cellNetEnd(movedCellId); ++net)
     {
-        Net *movedCellNet = _netArray[movedCellNetList[i]];
-        int fromSide = movedCellNet->getPartCount(movedCell->getPart()), toSide = movedCellNet->getPartCount(!movedCell->getPart());
+        // the large nets are left out of the gains, refinePasses recounts their cut
+        if (_netLarge[*net])
+        {
+            continue;
+        }
+        int fromSide = _netPartCount[2 * *net + movedPart], toSide = _netPartCount[2 * *net + !movedPart];
+        int netWeight = _graph.getNetWeight(*net);
+        const int *cellBegin = _graph.netCellBegin(*net), *cellEnd = _graph.netCellEnd(*net);
+
+        // bit p of the lock flags tells whether the net has a locked cell in partition p
+        char lockFlags = _netLockFlags[*net];
+        bool fromLocked = lockFlags & (1 << movedPart), toLocked = lockFlags & (1 << !movedPart);
+        _netLockFlags[*net] = lockFlags | (1 << !movedPart);
+
+        // a net locked on both sides stays cut, no gain on it can change anymore
+        if (fromLocked && toLocked)
+        {
+            continue;
+        }
+
+        // the single cell of a side is still found by a scan: an xor of the cell ids per side would find it in
+        // constant time, but a scan only runs when a side count reaches 1, and keeping the xor costs every move
+        // more than the scans save (F-M about 15% slower on nets of 200-3000 pins)
         if (toSide == 0)
         {
             // if toSide == 0, increment the gains of all free cells in the net
-            vector<int> movedCellNetCellList = movedCellNet->getCellList();
-            for (int j = 0; j < movedCellNetCellList.size(); ++j)
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
             {
-                Cell *freeCell = _cellArray[movedCellNetCellList[j]];
-                if (!freeCell->getLock())
+                if (!_nodeArray[*cell].isLocked())
                 {
-                    this->removeNode(freeCell->getNode());
-                    freeCell->incGain();
-                    this->addNode(freeCell->getNode());
+                    this->removeNode(bucket, *cell);
+                    _nodeArray[*cell].addGain(netWeight);
+                    ++_pass.gainUpdateNum;
+                    this->addNode(bucket, *cell);
                 }
             }
         }
-        else if (toSide == 1)
+        else if (toSide == 1 && !toLocked)
         {
-            // if toSide == 1, decrement the gain of the only free cell at toSide
-            vector<int> movedCellNetCellList = movedCellNet->getCellList();
-            for (int j = 0; j < movedCellNetCellList.size(); ++j)
+            // if toSide == 1, decrement the gain of the only cell at toSide, which is free
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
             {
-                Cell *freeCell = _cellArray[movedCellNetCellList[j]];
-                if (!freeCell->getLock() && freeCell->getPart() == !movedCell->getPart())
+                if (_nodeArray[*cell].getPart() == !movedPart)
                 {
-                    this->removeNode(freeCell->getNode());
-                    freeCell->decGain();
-                    this->addNode(freeCell->getNode());
+                    this->removeNode(bucket, *cell);
+                    _nodeArray[*cell].addGain(-netWeight);
+                    ++_pass.gainUpdateNum;
+                    this->addNode(bucket, *cell);
                     break;
                 }
             }
@@ -242,30 +548,28 @@ void Partitioner::updateGain()
         if (fromSide == 0)
         {
             // if fromSide == 0, decrement the gains of all free cells in the net
-            vector<int> movedCellNetCellList = movedCellNet->getCellList();
-            for (int j = 0; j < movedCellNetCellList.size(); ++j)
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
             {
-                Cell *freeCell = _cellArray[movedCellNetCellList[j]];
-                if (!freeCell->getLock())
+                if (!_nodeArray[*cell].isLocked())
                 {
-                    this->removeNode(freeCell->getNode());
-                    freeCell->decGain();
-                    this->addNode(freeCell->getNode());
+                    this->removeNode(bucket, *cell);
+                    _nodeArray[*cell].addGain(-netWeight);
+                    ++_pass.gainUpdateNum;
+                    this->addNode(bucket, *cell);
                 }
             }
         }
-        else if (fromSide == 1)
+        else if (fromSide == 1 && !fromLocked)
         {
-            // if fromSide == 1, increment the gain of the only free cell at fromSide
-            vector<int> movedCellNetCellList = movedCellNet->getCellList();
-            for (int j = 0; j < movedCellNetCellList.size(); ++j)
+            // if fromSide == 1, increment the gain of the only cell left at fromSide, which is free
+            for (const int *cell = cellBegin; cell != cellEnd; ++cell)
             {
-                Cell *freeCell = _cellArray[movedCellNetCellList[j]];
-                if (!freeCell->getLock() && freeCell->getPart() == movedCell->getPart())
+                if (!_nodeArray[*cell].isLocked() && _nodeArray[*cell].getPart() == movedPart)
                 {
-                    this->removeNode(freeCell->getNode());
-                    freeCell->incGain();
-                    this->addNode(freeCell->getNode());
+                    this->removeNode(bucket, *cell);
+                    _nodeArray[*cell].addGain(netWeight);
+                    ++_pass.gainUpdateNum;
+                    this->addNode(bucket, *cell);
                     break;
                 }
             }
@@ -273,18 +577,25 @@ void Partitioner::updateGain()
     }
 }
 
-bool Partitioner::pickMaxGainCell()
+template <class Policy>
+bool Partitioner::pickMaxGainCell(GainBucket<Policy> &bucket)
 {
     // decide which partition to pick
     bool pickedPart, part0Avail, part1Avail;
-    double lowerBound = (1 - _bFactor) / 2 * _cellNum, upperBound = (1 + _bFactor) / 2 * _cellNum;
+    double lowerBound[2] = {this->getLowerBound(0), this->getLowerBound(1)};
+    double upperBound[2] = {this->getUpperBound(0), this->getUpperBound(1)};
+
+    // the policy chooses among the cells of the max bucket of each partition
+    int maxCell[2] = {bucket.pick(0), bucket.pick(1)};
 
     // check if the partition is available
-    part0Avail = !_bList[0].empty() && _partSize[0] - 1 >= lowerBound && _partSize[0] - 1 <= upperBound;
-    part1Avail = !_bList[1].empty() && _partSize[1] - 1 >= lowerBound && _partSize[1] - 1 <= upperBound;
+    int weight0 = maxCell[0] != -1 ? _graph.getCellWeight(maxCell[0]) : 0;
+    int weight1 = maxCell[1] != -1 ? _graph.getCellWeight(maxCell[1]) : 0;
+    part0Avail = maxCell[0] != -1 && _partSize[0] - weight0 >= lowerBound[0] && _partSize[1] + weight0 <= upperBound[1];
+    part1Avail = maxCell[1] != -1 && _partSize[1] - weight1 >= lowerBound[1] && _partSize[0] + weight1 <= upperBound[0];
 
     // early stop if reaching the stop constant
-    if (_moveNum >= _stopConstant)
+    if (_stopPolicy->shouldStop(_moveNum, _accGain, _maxAccGain))
     {
         return 0;
     }
@@ -292,10 +603,7 @@ bool Partitioner::pickMaxGainCell()
     // decide which partition to pick
     if (part0Avail && part1Avail)
     {
-        map<int, Node *>::iterator max0It = _bList[0].end(), max1It = _bList[1].end();
-        max0It--;
-        max1It--;
-        pickedPart = max0It->first > max1It->first ? 0 : 1;
+        pickedPart = bucket.getMaxIdx(0) > bucket.getMaxIdx(1) ? 0 : 1;
     }
     else if (part0Avail)
     {
@@ -310,46 +618,29 @@ bool Partitioner::pickMaxGainCell()
         return 0;
     }
 
-    // pick the max gain cell
-    map<int, Node *>::iterator maxIt = _bList[pickedPart].end();
-    maxIt--;
-    Node *pickedNode;
-
-    // choose the node with larger sorting index in the front two of the linked list
-    if (maxIt->second->getNext() != NULL)
-    {
-        pickedNode = _cellArray[maxIt->second->getId()]->getSortingIndex() > _cellArray[maxIt->second->getNext()->getId()]->getSortingIndex() ? maxIt->second : maxIt->second->getNext();
-    }
-    else
-    {
-        pickedNode = maxIt->second;
-    }
-
     // remove the picked node from the bucket list, therefore no lock node in the bucket list
-    this->removeNode(pickedNode);
-    _maxGainCell = pickedNode;
+    this->removeNode(bucket, maxCell[pickedPart]);
+    _maxGainCell = maxCell[pickedPart];
     return 1;
 }
 
 void Partitioner::moveCell()
 {
     // move the max gain cell
-    Cell *movedCell = _cellArray[_maxGainCell->getId()];
-    bool fromPart = movedCell->getPart();
-    movedCell->move();
+    int movedCellId = _maxGainCell;
+    bool fromPart = _nodeArray[movedCellId].getPart();
+    _nodeArray[movedCellId].setPart(!fromPart);
 
     // update nets connected to the moved cell
-    vector<int> movedCellNetList = movedCell->getNetList();
-    for (int i = 0; i < movedCellNetList.size(); ++i)
+    for (const int *net = _graph.cellNetBegin(movedCellId); net != _graph.cellNetEnd(movedCellId); ++net)
     {
-        Net *movedCellNet = _netArray[movedCellNetList[i]];
-        movedCellNet->decPartCount(fromPart);
-        movedCellNet->incPartCount(!fromPart);
+        _netPartCount[2 * *net + fromPart]--;
+        _netPartCount[2 * *net + !fromPart]++;
     }
 
     // update partition
-    _moveStack.push_back(_maxGainCell->getId());
-    _accGain += movedCell->getGain();
+    _moveStack.push_back(movedCellId);
+    _accGain += _nodeArray[movedCellId].getGain();
     ++_moveNum;
     if (_maxAccGain < _accGain)
     {
@@ -357,8 +648,8 @@ void Partitioner::moveCell()
         _bestMoveNum = _moveNum;
     }
     _unlockNum[fromPart]--;
-    --_partSize[fromPart];
-    ++_partSize[!fromPart];
+    _partSize[fromPart] -= _graph.getCellWeight(movedCellId);
+    _partSize[!fromPart] += _graph.getCellWeight(movedCellId);
 }
 
 void Partitioner::toBest()
@@ -366,16 +657,16 @@ void Partitioner::toBest()
     // back to the best move
     for (int i = _moveNum - 1; i >= _bestMoveNum; --i)
     {
-        Cell *restoredCell = _cellArray[_moveStack[i]];
-        restoredCell->move();
-        for (int j = 0; j < restoredCell->getNetList().size(); ++j)
+        int restoredCellId = _moveStack[i];
+        bool restoredPart = !_nodeArray[restoredCellId].getPart();
+        _nodeArray[restoredCellId].setPart(restoredPart);
+        for (const int *net = _graph.cellNetBegin(restoredCellId); net != _graph.cellNetEnd(restoredCellId); ++net)
         {
-            Net *restoredCellNet = _netArray[restoredCell->getNetList()[j]];
-            restoredCellNet->decPartCount(!restoredCell->getPart());
-            restoredCellNet->incPartCount(restoredCell->getPart());
+            _netPartCount[2 * *net + !restoredPart]--;
+            _netPartCount[2 * *net + restoredPart]++;
         }
-        ++_partSize[restoredCell->getPart()];
-        --_partSize[!restoredCell->getPart()];
+        _partSize[restoredPart] += _graph.getCellWeight(restoredCellId);
+        _partSize[!restoredPart] -= _graph.getCellWeight(restoredCellId);
     }
     _cutSize -= _maxAccGain;
 }
@@ -390,78 +681,266 @@ void Partitioner::reRunInit()
     _moveStack.clear();
 
     // unlock all cells
+    fill(_netLockFlags.begin(), _netLockFlags.end(), 0);
     for (int i = 0; i < _cellNum; ++i)
     {
-        Cell *pickedCell = _cellArray[i];
-        pickedCell->unlock();
-        pickedCell->setGain(0);
-        this->removeNode(pickedCell->getNode());
+        _nodeArray[i].reset();
     }
+    return;
+}
 
-    // initialize blist
-    for (int i = 0; i < 2; ++i)
+// scan the next whitespace separated token of [cur, end) in place
+static bool nextToken(const char *&cur, const char *end, const char *&tokenBegin, const char *&tokenEnd)
+{
+    while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r' || *cur == '\v' || *cur == '\f'))
     {
-        _bList[i].clear();
+        ++cur;
     }
-    return;
+    if (cur == end)
+    {
+        return false;
+    }
+    tokenBegin = cur;
+    while (cur != end && !(*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r' || *cur == '\v' || *cur == '\f'))
+    {
+        ++cur;
+    }
+    tokenEnd = cur;
+    return true;
 }
 
-void Partitioner::parseInput(fstream &inFile)
+static bool tokenIs(const char *tokenBegin, const char *tokenEnd, const char *str)
 {
-    string str;
+    size_t length = strlen(str);
+    return (size_t)(tokenEnd - tokenBegin) == length && memcmp(tokenBegin, str, length) == 0;
+}
+
+void Partitioner::parseInput(const char *inFileName)
+{
+    // map the whole file and tokenize it in place
+    int fd = open(inFileName, O_RDONLY);
+    struct stat fileStat;
+    if (fd < 0 || fstat(fd, &fileStat) < 0)
+    {
+        cerr << "Cannot open the input file \"" << inFileName
+             << "\". The program will be terminated..." << endl;
+        exit(1);
+    }
+    _inputSize = fileStat.st_size;
+    const char *data = NULL;
+    if (_inputSize > 0)
+    {
+        void *mapped = mmap(NULL, _inputSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            cerr << "Cannot map the input file \"" << inFileName
+                 << "\". The program will be terminated..." << endl;
+            exit(1);
+        }
+        madvise(mapped, _inputSize, MADV_SEQUENTIAL);
+        data = (const char *)mapped;
+    }
+    const char *cur = data, *end = data + _inputSize, *tokenBegin, *tokenEnd;
+
     // Set balance factor
-    inFile >> str;
-    _bFactor = stod(str);
+    if (nextToken(cur, end, tokenBegin, tokenEnd))
+    {
+        char buff[64] = {0};
+        memcpy(buff, tokenBegin, min((size_t)(tokenEnd - tokenBegin), sizeof(buff) - 1));
+        _bFactor = strtod(buff, NULL);
+    }
 
     // Set up whole circuit
-    while (inFile >> str)
+    while (nextToken(cur, end, tokenBegin, tokenEnd))
     {
-        if (str == "NET")
+        if (tokenIs(tokenBegin, tokenEnd, "NET"))
         {
-            string netName, cellName, tmpCellName = "";
-            inFile >> netName;
-            int netId = _netNum;
-            _netArray.push_back(new Net(netName));
-            _netName2Id[netName] = netId;
-            while (inFile >> cellName)
+            if (!nextToken(cur, end, tokenBegin, tokenEnd))
             {
-                if (cellName == ";")
+                break;
+            }
+            _netArray.push_back(Net(_netNames.store(tokenBegin, tokenEnd)));
+            int prevCellId = -1;
+            while (nextToken(cur, end, tokenBegin, tokenEnd))
+            {
+                if (tokenIs(tokenBegin, tokenEnd, ";"))
                 {
-                    tmpCellName = "";
                     break;
                 }
-                else
+                bool inserted = false;
+                int cellId = _cellNames.intern(tokenBegin, tokenEnd, inserted);
+                // a newly seen cell
+                if (inserted)
                 {
-                    // a newly seen cell
-                    if (_cellName2Id.count(cellName) == 0)
-                    {
-                        int cellId = _cellNum;
-                        _cellArray.push_back(new Cell(cellName, 0, cellId));
-                        _cellName2Id[cellName] = cellId;
-                        _cellArray[cellId]->addNet(netId);
-                        _cellArray[cellId]->incPinNum();
-                        _netArray[netId]->addCell(cellId);
-                        ++_cellNum;
-                        tmpCellName = cellName;
-                    }
-                    // an existed cell
-                    else
-                    {
-                        if (cellName != tmpCellName)
-                        {
-                            assert(_cellName2Id.count(cellName) == 1);
-                            int cellId = _cellName2Id[cellName];
-                            _cellArray[cellId]->addNet(netId);
-                            _cellArray[cellId]->incPinNum();
-                            _netArray[netId]->addCell(cellId);
-                            tmpCellName = cellName;
-                        }
-                    }
+                    _ownGraph.addCell();
+                    _cellArray.push_back(Cell(_cellNames.getName(cellId)));
+                    ++_cellNum;
+                }
+                // skip a cell repeated right after itself
+                if (cellId != prevCellId)
+                {
+                    _ownGraph.addPin(cellId);
+                    prevCellId = cellId;
                 }
             }
+            _ownGraph.closeNet();
             ++_netNum;
         }
     }
+    if (data != NULL)
+    {
+        munmap((void *)data, _inputSize);
+    }
+    close(fd);
+
+    // build the cell to net adjacency and the flat state arrays
+    _ownGraph.buildCellNets();
+    this->initState();
+    return;
+}
+
+bool Partitioner::loadSnapshot(const char *snapshotName, const char *inFileName)
+{
+    int fd = open(snapshotName, O_RDONLY);
+    struct stat snapshotStat;
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (fstat(fd, &snapshotStat) < 0 || (size_t)snapshotStat.st_size < sizeof(SnapshotHeader))
+    {
+        close(fd);
+        return false;
+    }
+    size_t snapshotSize = snapshotStat.st_size;
+    void *mapped = mmap(NULL, snapshotSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        return false;
+    }
+    const char *data = (const char *)mapped;
+    SnapshotHeader header;
+    memcpy(&header, data, sizeof(SnapshotHeader));
+
+    // reject snapshots of another layout, of another (or a modified) netlist, or with a bad checksum
+    bool valid = memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                 header.version == SNAPSHOT_VERSION && header.headerSize == sizeof(SnapshotHeader) &&
+                 header.payloadSize == snapshotSize - sizeof(SnapshotHeader);
+    struct stat sourceStat;
+    if (valid && stat(inFileName, &sourceStat) == 0)
+    {
+        valid = header.sourceSize == (uint64_t)sourceStat.st_size &&
+                header.sourceMtime == (int64_t)sourceStat.st_mtim.tv_sec * 1000000000LL + sourceStat.st_mtim.tv_nsec;
+    }
+    if (valid)
+    {
+        valid = header.checksum == snapshotChecksum(data + sizeof(SnapshotHeader), header.payloadSize);
+    }
+    if (!valid)
+    {
+        cerr << "Snapshot \"" << snapshotName << "\" is stale or corrupted, the input will be parsed again." << endl;
+        munmap(mapped, snapshotSize);
+        return false;
+    }
+
+    // copy the CSR arrays, names stay in the mapping
+    const char *names = _ownGraph.readBinary(data + sizeof(SnapshotHeader), header.cellNum, header.netNum);
+    for (int i = 0; i < header.cellNum; ++i)
+    {
+        _cellArray.push_back(Cell(names));
+        names += strlen(names) + 1;
+    }
+    for (int i = 0; i < header.netNum; ++i)
+    {
+        _netArray.push_back(Net(names));
+        names += strlen(names) + 1;
+    }
+    _bFactor = header.bFactor;
+    _cellNum = header.cellNum;
+    _netNum = header.netNum;
+    _snapshotData = data;
+    _snapshotSize = snapshotSize;
+    _inputSize = snapshotSize;
+    this->initState();
+    return true;
+}
+
+void Partitioner::writeSnapshot(const char *snapshotName, const char *inFileName) const
+{
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(SnapshotHeader));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    struct stat sourceStat;
+    if (stat(inFileName, &sourceStat) == 0)
+    {
+        header.sourceSize = sourceStat.st_size;
+        header.sourceMtime = (int64_t)sourceStat.st_mtim.tv_sec * 1000000000LL + sourceStat.st_mtim.tv_nsec;
+    }
+    header.bFactor = _bFactor;
+    header.cellNum = _cellNum;
+    header.netNum = _netNum;
+
+    // write to a temporary file and rename it, so readers never see a half-written snapshot
+    string tmpName = string(snapshotName) + ".tmp";
+    {
+        fstream outFile(tmpName.c_str(), ios::out | ios::binary | ios::trunc);
+        if (!outFile)
+        {
+            cerr << "Cannot write the snapshot \"" << snapshotName << "\"." << endl;
+            return;
+        }
+        outFile.write((const char *)&header, sizeof(SnapshotHeader));
+        _graph.writeBinary(outFile);
+        for (int i = 0; i < _cellNum; ++i)
+        {
+            outFile.write(_cellArray[i].getName(), strlen(_cellArray[i].getName()) + 1);
+        }
+        for (int i = 0; i < _netNum; ++i)
+        {
+            outFile.write(_netArray[i].getName(), strlen(_netArray[i].getName()) + 1);
+        }
+    }
+
+    // checksum the payload through a mapping and patch the header
+    int fd = open(tmpName.c_str(), O_RDWR);
+    struct stat snapshotStat;
+    if (fd < 0 || fstat(fd, &snapshotStat) < 0)
+    {
+        cerr << "Cannot write the snapshot \"" << snapshotName << "\"." << endl;
+        return;
+    }
+    header.payloadSize = snapshotStat.st_size - sizeof(SnapshotHeader);
+    void *mapped = header.payloadSize > 0 ? mmap(NULL, snapshotStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    if (mapped != MAP_FAILED)
+    {
+        header.checksum = snapshotChecksum((const char *)mapped + sizeof(SnapshotHeader), header.payloadSize);
+        munmap(mapped, snapshotStat.st_size);
+    }
+    bool written = pwrite(fd, &header, sizeof(SnapshotHeader), 0) == (ssize_t)sizeof(SnapshotHeader);
+    close(fd);
+    if (!written || rename(tmpName.c_str(), snapshotName) != 0)
+    {
+        cerr << "Cannot write the snapshot \"" << snapshotName << "\"." << endl;
+        unlink(tmpName.c_str());
+    }
+    return;
+}
+
+void Partitioner::initState()
+{
+    // unnamed cells (built from a hypergraph) still carry their sorting index
+    _cellArray.resize(_cellNum, Cell(""));
+    _nodeArray.assign(_cellNum, Node());
+    _netPartCount.assign(2 * _netNum, 0);
+    _netLockFlags.assign(_netNum, 0);
+    _netLarge.assign(_netNum, 0);
+    _passGain.assign(_cellNum, 0);
+    _cellKept.assign(_cellNum, false);
+    _netStamp.assign(_netNum, -1);
+    _moveStack.reserve(_cellNum);
     return;
 }
 
@@ -469,38 +948,187 @@ void Partitioner::partition()
 {
     // initialize partition
     this->initPartition();
-    cout << "Initial cutsize: " << _cutSize << endl;
+    if (_verbose)
+    {
+        cout << "Initial cutsize: " << _cutSize << endl;
+    }
+    this->refine();
+}
+
+void Partitioner::getPartition(vector<char> &cellPart) const
+{
+    cellPart.resize(_cellNum);
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        cellPart[i] = _nodeArray[i].getPart();
+    }
+    return;
+}
 
+void Partitioner::refine()
+{
+    // the policy is fixed for the whole refine, so the move loop is compiled once per policy
+    if (_bucketPolicy == BUCKET_LIFO)
+    {
+        GainBucket<LifoPolicy> bucket(_nodeArray, LifoPolicy());
+        this->refinePasses(bucket);
+    }
+    else if (_bucketPolicy == BUCKET_FIFO)
+    {
+        GainBucket<FifoPolicy> bucket(_nodeArray, FifoPolicy());
+        this->refinePasses(bucket);
+    }
+    else if (_bucketPolicy == BUCKET_RANDOM)
+    {
+        GainBucket<RandomPolicy> bucket(_nodeArray, RandomPolicy(0));
+        this->refinePasses(bucket);
+    }
+    else if (_bucketPolicy == BUCKET_CLIP)
+    {
+        GainBucket<ClipPolicy> bucket(_nodeArray, ClipPolicy());
+        this->refinePasses(bucket);
+    }
+    else
+    {
+        GainBucket<SortingIndexPolicy> bucket(_nodeArray, SortingIndexPolicy(_cellArray));
+        this->refinePasses(bucket);
+    }
+}
+
+template <class Policy>
+void Partitioner::refinePasses(GainBucket<Policy> &bucket)
+{
     // start Fiduccia-Mattheyses algorithm
+    _iterNum = 0;
+    _passProfile.clear();
+    fill(_netStamp.begin(), _netStamp.end(), -1);
+    _gainCarried = false;
+    _cutDrift = 0;
+
+    // small graphs are not worth handing to worker threads
+    int threadNum = _threadNum > 0 ? _threadNum : thread::hardware_concurrency();
+    if (threadNum > 1 && _graph.getPinNum() >= PARALLEL_GAIN_PIN_NUM)
+    {
+        _gainPool = new ThreadPool(threadNum);
+    }
     while (true)
     {
+        _pass = PassProfile();
+        int cutSize = _cutSize, largeCutSize = this->getLargeCutSize();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
         this->initGain();
-        // set stop constant
-        _stopConstant = _iterNum == 0 ? _cellNum * 0.5 : _cellNum * 0.2;
+        this->fillBucket(bucket);
+        _pass.initGainTime = secondsSince(start);
+        _stopPolicy->startPass(_iterNum, _cellNum);
         _iterNum++;
 
         // start partitioning
-        while (this->pickMaxGainCell())
+        start = chrono::steady_clock::now();
+        while (this->pickMaxGainCell(bucket))
         {
-            this->updateGain();
+            // reading the clock costs about as much as a small move, so only every 16th updateGain is timed
+            if ((_moveNum & 15) == 0)
+            {
+                chrono::steady_clock::time_point updateStart = chrono::steady_clock::now();
+                this->updateGain(bucket);
+                _pass.updateGainTime += 16 * secondsSince(updateStart);
+            }
+            else
+            {
+                this->updateGain(bucket);
+            }
             this->moveCell();
         }
+        _pass.moveTime = secondsSince(start);
 
         // decide whether to stop partitioning
-        if (_maxAccGain > 0)
+        // cout << "max accumulated gain: " << _maxAccGain << endl;
+        _pass.moveNum = _moveNum;
+        _pass.keptNum = _bestMoveNum;
+        _pass.rollbackNum = _moveNum - _bestMoveNum;
+        start = chrono::steady_clock::now();
+        this->toBest();
+        _pass.rollbackTime = secondsSince(start);
+
+        // the kept prefix was chosen without the large nets, add their actual cut change
+        _pass.cutDrift = this->getLargeCutSize() - largeCutSize;
+        _cutSize += _pass.cutDrift;
+        _cutDrift += _pass.cutDrift;
+        // the cut test guards the bookkeeping itself, a pass never ends above the cut it started from
+        bool improved = _maxAccGain - _pass.cutDrift > 0 && _cutSize < cutSize;
+        if (!improved)
         {
-            // cout << "max accumulated gain: " << _maxAccGain << endl;
+            // the drift ate the gain of the kept prefix, roll it back too so the pass leaves the cut as it found it
+            _moveNum = _bestMoveNum;
+            _bestMoveNum = 0;
             this->toBest();
-            this->reRunInit();
+            _cutSize = cutSize;
+            _cutDrift -= _pass.cutDrift;
+            _pass.rollbackNum += _pass.keptNum;
+            _pass.keptNum = 0;
+            _pass.cutDrift = 0;
         }
-        else
+        start = chrono::steady_clock::now();
+        this->carryGain();
+        _pass.carryGainTime = secondsSince(start);
+        _passProfile.push_back(_pass);
+        this->reRunInit();
+        if (!improved || _iterNum == _maxPassNum)
         {
-            // cout << "max accumulated gain: " << _maxAccGain << endl;
             // cout << "No more improvement, stop partitioning." << endl;
-            this->toBest();
             break;
         }
     }
+    delete _gainPool;
+    _gainPool = NULL;
+}
+
+void Partitioner::setLargeNetSize(const int largeNetSize)
+{
+    // nets above the threshold stay out of the gains, clock and reset nets rarely change state but cost most updates
+    _largeNetSize = largeNetSize;
+    _largeNets.clear();
+    for (int i = 0; i < _netNum; ++i)
+    {
+        _netLarge[i] = _largeNetSize > 0 && _graph.getNetSize(i) > _largeNetSize;
+        if (_netLarge[i])
+        {
+            _largeNets.push_back(i);
+        }
+    }
+}
+
+int Partitioner::getLargeCutSize() const
+{
+    int cutSize = 0;
+    for (size_t i = 0; i < _largeNets.size(); ++i)
+    {
+        int netId = _largeNets[i];
+        if (_netPartCount[2 * netId] > 0 && _netPartCount[2 * netId + 1] > 0)
+        {
+            cutSize += _graph.getNetWeight(netId);
+        }
+    }
+    return cutSize;
+}
+
+double Partitioner::getLowerBound(int part) const
+{
+    // the balance window of a part scales with its target share of the total weight
+    double share = part == 0 ? _targetRatio : 1 - _targetRatio;
+    return (1 - _bFactor) / 2 * _graph.getTotalCellWeight() * (2 * share);
+}
+
+double Partitioner::getUpperBound(int part) const
+{
+    double share = part == 0 ? _targetRatio : 1 - _targetRatio;
+    return (1 + _bFactor) / 2 * _graph.getTotalCellWeight() * (2 * share);
+}
+
+bool Partitioner::isBalanced() const
+{
+    return _partSize[0] >= this->getLowerBound(0) && _partSize[0] <= this->getUpperBound(0) &&
+           _partSize[1] >= this->getLowerBound(1) && _partSize[1] <= this->getUpperBound(1);
 }
 
 void Partitioner::printSummary() const
@@ -512,6 +1140,18 @@ void Partitioner::printSummary() const
     cout << " Total net number:  " << _netNum << endl;
     cout << " Cell Number of partition A: " << _partSize[0] << endl;
     cout << " Cell Number of partition B: " << _partSize[1] << endl;
+    // modes refining on their own (ECO, parallel F-M, label propagation alone) report their passes themselves
+    if (_iterNum > 0)
+    {
+        cout << " Stop policy: " << _stopPolicy->getName() << endl;
+        cout << " Passes: " << _iterNum << endl;
+        cout << " Moves per pass (kept/tried):";
+        for (int i = 0; i < _iterNum; ++i)
+        {
+            cout << " " << _passProfile[i].keptNum << "/" << _passProfile[i].moveNum;
+        }
+        cout << endl;
+    }
     cout << "=================================================" << endl;
     cout << endl;
     return;
@@ -522,11 +1162,10 @@ void Partitioner::reportNet() const
     cout << "Number of nets: " << _netNum << endl;
     for (size_t i = 0, end_i = _netArray.size(); i < end_i; ++i)
     {
-        cout << setw(8) << _netArray[i]->getName() << ": ";
-        vector<int> cellList = _netArray[i]->getCellList();
-        for (size_t j = 0, end_j = cellList.size(); j < end_j; ++j)
+        cout << setw(8) << _netArray[i].getName() << ": ";
+        for (const int *cell = _graph.netCellBegin(i); cell != _graph.netCellEnd(i); ++cell)
         {
-            cout << setw(8) << _cellArray[cellList[j]]->getName() << " ";
+            cout << setw(8) << _cellArray[*cell].getName() << " ";
         }
         cout << endl;
     }
@@ -538,11 +1177,10 @@ void Partitioner::reportCell() const
     cout << "Number of cells: " << _cellNum << endl;
     for (size_t i = 0, end_i = _cellArray.size(); i < end_i; ++i)
     {
-        cout << setw(8) << _cellArray[i]->getName() << ": ";
-        vector<int> netList = _cellArray[i]->getNetList();
-        for (size_t j = 0, end_j = netList.size(); j < end_j; ++j)
+        cout << setw(8) << _cellArray[i].getName() << ": ";
+        for (const int *net = _graph.cellNetBegin(i); net != _graph.cellNetEnd(i); ++net)
         {
-            cout << setw(8) << _netArray[netList[j]]->getName() << " ";
+            cout << setw(8) << _netArray[*net].getName() << " ";
         }
         cout << endl;
     }
@@ -559,9 +1197,9 @@ void Partitioner::writeResult(fstream &outFile)
     outFile << "G1 " << buff.str() << '\n';
     for (size_t i = 0, end = _cellArray.size(); i < end; ++i)
     {
-        if (_cellArray[i]->getPart() == 0)
+        if (_nodeArray[i].getPart() == 0)
         {
-            outFile << _cellArray[i]->getName() << " ";
+            outFile << _cellArray[i].getName() << " ";
         }
     }
     outFile << ";\n";
@@ -570,9 +1208,9 @@ void Partitioner::writeResult(fstream &outFile)
     outFile << "G2 " << buff.str() << '\n';
     for (size_t i = 0, end = _cellArray.size(); i < end; ++i)
     {
-        if (_cellArray[i]->getPart() == 1)
+        if (_nodeArray[i].getPart() == 1)
         {
-            outFile << _cellArray[i]->getName() << " ";
+            outFile << _cellArray[i].getName() << " ";
         }
     }
     outFile << ";\n";
@@ -581,13 +1219,13 @@ void Partitioner::writeResult(fstream &outFile)
 
 void Partitioner::clear()
 {
-    for (size_t i = 0, end = _cellArray.size(); i < end; ++i)
-    {
-        delete _cellArray[i];
-    }
-    for (size_t i = 0, end = _netArray.size(); i < end; ++i)
+    if (_snapshotData != NULL)
     {
-        delete _netArray[i];
+        munmap((void *)_snapshotData, _snapshotSize);
     }
+    // cells, nets and nodes live in contiguous arrays which release themselves in one shot
+    _cellArray.clear();
+    _netArray.clear();
+    _nodeArray.clear();
     return;
 }
@@ -3,25 +3,48 @@
 
 #include <fstream>
 #include <vector>
-#include <map>
-#include <unordered_map>
 #include "cell.h"
+#include "bucket.h"
 #include "net.h"
+#include "hypergraph.h"
+#include "nametable.h"
+#include "stoppolicy.h"
+#include "profile.h"
 using namespace std;
 
+class ThreadPool;
+
 class Partitioner
 {
 public:
     // constructor and destructor
-    Partitioner(fstream& inFile) :
-        _cutSize(0), _netNum(0), _cellNum(0), _maxPinNum(0), _bFactor(0),
-        _accGain(0), _maxAccGain(0), _iterNum(0) {
-        parseInput(inFile);
+    // parse a netlist, or load it from a binary snapshot which is (re)written when missing or stale
+    Partitioner(const char* inFileName, const char* snapshotName = NULL) :
+        _graph(_ownGraph), _cutSize(0), _netNum(0), _cellNum(0), _maxPinNum(0), _bFactor(0), _targetRatio(0.5), _inputSize(0),
+        _snapshotData(NULL), _snapshotSize(0),
+        _accGain(0), _maxAccGain(0), _moveNum(0), _iterNum(0), _bestMoveNum(0), _gainCarried(false), _growInit(false), _verbose(true), _bucketPolicy(BUCKET_INDEX), _threadNum(1), _gainPool(NULL), _maxPassNum(0), _largeNetSize(0), _cutDrift(0), _stopPolicy(new FixedFractionStop()) {
+        if (snapshotName == NULL || !loadSnapshot(snapshotName, inFileName)) {
+            parseInput(inFileName);
+            if (snapshotName != NULL) {
+                writeSnapshot(snapshotName, inFileName);
+            }
+        }
+        _partSize[0] = 0;
+        _partSize[1] = 0;
+    }
+    // partition an already built hypergraph (e.g. a coarsened one) without copying it,
+    // the graph is only read, so several partitioners may share it across threads
+    Partitioner(const Hypergraph& graph, double bFactor) :
+        _graph(graph), _cutSize(0), _netNum(graph.getNetNum()), _cellNum(graph.getCellNum()), _maxPinNum(0), _bFactor(bFactor), _targetRatio(0.5), _inputSize(0),
+        _snapshotData(NULL), _snapshotSize(0),
+        _accGain(0), _maxAccGain(0), _moveNum(0), _iterNum(0), _bestMoveNum(0), _gainCarried(false), _growInit(false), _verbose(true), _bucketPolicy(BUCKET_INDEX), _threadNum(1), _gainPool(NULL), _maxPassNum(0), _largeNetSize(0), _cutDrift(0), _stopPolicy(new FixedFractionStop()) {
+        initState();
         _partSize[0] = 0;
         _partSize[1] = 0;
     }
     ~Partitioner() {
         clear();
+        delete _stopPolicy;
     }
 
     // basic access methods
@@ -29,11 +52,54 @@ public:
     int getNetNum() const           { return _netNum; }
     int getCellNum() const          { return _cellNum; }
     double getBFactor() const       { return _bFactor; }
+    double getTargetRatio() const   { return _targetRatio; }
+    size_t getInputSize() const     { return _inputSize; }
+    bool isFromSnapshot() const     { return _snapshotData != NULL; }
     int getPartSize(int part) const { return _partSize[part]; }
+    const Hypergraph& getGraph() const  { return _graph; }
+    const char* getCellName(int cellId) const   { return _cellArray[cellId].getName(); }
+    double getLowerBound(int part) const;
+    double getUpperBound(int part) const;
+    bool isBalanced() const;
+    bool isGrowInit() const                     { return _growInit; }
+    bool isVerbose() const                      { return _verbose; }
+    BucketPolicy getBucketPolicy() const        { return _bucketPolicy; }
+    int getLargeNetSize() const                 { return _largeNetSize; }
+    int getLargeNetNum() const                  { return (int)_largeNets.size(); }
+    // cut change of the large nets over the last refine, which the gains did not see
+    int getCutDrift() const                     { return _cutDrift; }
+    const StopPolicy& getStopPolicy() const     { return *_stopPolicy; }
+    int getPassNum() const                      { return _iterNum; }
+    int getPassMoveNum(int pass) const          { return _passProfile[pass].moveNum; }
+    int getPassKeptNum(int pass) const          { return _passProfile[pass].keptNum; }
+    const vector<PassProfile>& getPassProfile() const   { return _passProfile; }
+
+    // set functions
+    // share of the total weight aimed at A, e.g. 1/3 when a bisection feeds one block to A and two to B
+    void setTargetRatio(const double targetRatio)   { _targetRatio = targetRatio; }
+    // threads of the gain initialization, <= 0 means one per hardware thread
+    void setThreadNum(const int threadNum)          { _threadNum = threadNum; }
+    // start initPartition from a grown region instead of the sorting index split
+    void setGrowInit(const bool growInit)           { _growInit = growInit; }
+    // print the initial cut size in partition, off when used as a library
+    void setVerbose(const bool verbose)             { _verbose = verbose; }
+    // selection inside the max gain bucket, the move loop is compiled once per policy
+    void setBucketPolicy(const BucketPolicy bucketPolicy)   { _bucketPolicy = bucketPolicy; }
+    // stop refining after this many passes, 0 means until a pass brings no improvement
+    void setMaxPassNum(const int maxPassNum)        { _maxPassNum = maxPassNum; }
+    // leave nets with more pins than this out of the gains, their cut is recounted after each pass, 0 for none
+    void setLargeNetSize(const int largeNetSize);
+    void setStopPolicy(const StopPolicy& stopPolicy) {
+        delete _stopPolicy;
+        _stopPolicy = stopPolicy.clone();
+    }
 
     // modify method
-    void parseInput(fstream& inFile);
+    void parseInput(const char* inFileName);
+    bool loadSnapshot(const char* snapshotName, const char* inFileName);
+    void writeSnapshot(const char* snapshotName, const char* inFileName) const;
     void partition();
+    void refine();
 
     // member functions about reporting
     void printSummary() const;
@@ -43,28 +109,51 @@ public:
 
     // added member functions
     void initPartition();
-    void addNode(Node* targetNode);
-    void removeNode(Node* targetNode);
+    void initPartition(const vector<char>& cellPart);
+    void initPerturbedPartition(unsigned seed);
+    void initGrowingPartition(unsigned seed = 0);
+    template <class Policy> void addNode(GainBucket<Policy>& bucket, int cellId);
+    template <class Policy> void removeNode(GainBucket<Policy>& bucket, int cellId);
+    template <class Policy> void fillBucket(GainBucket<Policy>& bucket);
     void initGain();
-    void updateGain();
-    bool pickMaxGainCell();
+    void computeGain(int beginCell, int endCell);
+    void carryGain();
+    template <class Policy> void updateGain(GainBucket<Policy>& bucket);
+    template <class Policy> bool pickMaxGainCell(GainBucket<Policy>& bucket);
     void moveCell();
     void toBest();
     void reRunInit();
 
+    // flat per-cell and per-net state
+    bool getCellPart(int cellId) const              { return _nodeArray[cellId].getPart(); }
+    int getNetPartCount(int netId, int part) const  { return _netPartCount[2 * netId + part]; }
+    // partition of every cell (0-A, 1-B) by cell id, the read-back of in-memory callers
+    void getPartition(vector<char>& cellPart) const;
+
 private:
+    const Hypergraph&   _graph;         // CSR adjacency of the circuit (_ownGraph or a shared one)
+    Hypergraph          _ownGraph;      // hypergraph parsed by this partitioner
     int                 _cutSize;       // cut size
-    int                 _partSize[2];   // size (cell number) of partition A(0) and B(1)
+    int                 _partSize[2];   // size (cell weight) of partition A(0) and B(1)
     int                 _netNum;        // number of nets
     int                 _cellNum;       // number of cells
     int                 _maxPinNum;     // Pmax for building bucket list
     double              _bFactor;       // the balance factor to be met
-    Node*               _maxGainCell;   // pointer to max gain cell
-    vector<Net*>        _netArray;      // net array of the circuit
-    vector<Cell*>       _cellArray;     // cell array of the circuit
-    map<int, Node*>     _bList[2];      // bucket list of partition A(0) and B(1)
-    unordered_map<string, int>    _netName2Id;    // mapping from net name to id
-    unordered_map<string, int>    _cellName2Id;   // mapping from cell name to id
+    double              _targetRatio;   // target share of the total weight in A (0.5 for a bisection)
+    size_t              _inputSize;     // bytes of the parsed input file (or of the loaded snapshot)
+    const char*         _snapshotData;  // mapped snapshot, cell and net names point into it
+    size_t              _snapshotSize;  // bytes of the mapped snapshot
+    int                 _maxGainCell;   // id of the max gain cell
+    vector<Net>         _netArray;      // net array of the circuit
+    vector<Cell>        _cellArray;     // cell array of the circuit
+    vector<Node>        _nodeArray;     // hot state (gain, bucket links, part and lock) of each cell
+    vector<int>         _passGain;      // gain of each cell at the start of the pass, carried over to the next one
+    vector<char>        _cellKept;      // whether each cell is in the kept prefix of the last pass
+    vector<int>         _netStamp;      // last pass in which each net was refreshed by carryGain
+    vector<int>         _netPartCount;  // cell number of each net in A(2 * id) and B(2 * id + 1)
+    vector<char>        _netLockFlags;  // whether each net has a locked cell in A (bit 0) and B (bit 1)
+    NameTable           _cellNames;     // interned cell names, id of a name is the cell id
+    NameTable           _netNames;      // arena of the net names
  
     int                 _accGain;       // accumulative gain
     int                 _maxAccGain;    // maximum accumulative gain
@@ -73,9 +162,30 @@ private:
     int                 _bestMoveNum;   // store best number of movements
     int                 _unlockNum[2];  // number of unlocked cells
     vector<int>         _moveStack;     // history of cell movement
+    bool                _gainCarried;   // whether _passGain already holds the gains of the next pass
+    bool                _growInit;      // whether initPartition (and initPerturbedPartition) grows A from a cell
+    bool                _verbose;       // whether partition prints the initial cut size
+    BucketPolicy        _bucketPolicy;  // selection policy of the gain buckets
+    int                 _threadNum;     // number of threads of the gain initialization
+    ThreadPool*         _gainPool;      // workers of the gain initialization during refine, NULL if sequential
+    int                 _maxPassNum;    // upper bound of the passes of refine, 0 if unbounded
+    int                 _largeNetSize;  // nets with more pins are left out of the gains, 0 for none
+    vector<char>        _netLarge;      // whether each net is above _largeNetSize
+    vector<int>         _largeNets;     // nets above _largeNetSize
+    int                 _cutDrift;      // cut change of the large nets over the last refine
 
     // added member variables
-    int                 _stopConstant;  // stop constant
+    StopPolicy*         _stopPolicy;    // decides when a pass stops moving cells
+    PassProfile         _pass;          // counters and timers of the current pass
+    vector<PassProfile> _passProfile;   // counters and timers of each pass of the last refine
+
+    // set up the flat state arrays once the hypergraph is built
+    void initState();
+    void initSortingIndex();
+    int findPeripheralCell() const;
+    void loadPartition(const vector<char>& cellPart);
+    int getLargeCutSize() const;
+    template <class Policy> void refinePasses(GainBucket<Policy>& bucket);
 
     // Clean up partitioner
     void clear();
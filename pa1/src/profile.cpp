@@ -0,0 +1,60 @@
+#include <ostream>
+#include <string>
+#include <vector>
+#include "profile.h"
+using namespace std;
+
+// one pass (or the totals) as a single line JSON object
+static void writePass(ostream &out, const PassProfile &pass)
+{
+    out << "{\"moves\": " << pass.moveNum << ", \"kept\": " << pass.keptNum << ", \"rollback\": " << pass.rollbackNum
+        << ", \"gain_updates\": " << pass.gainUpdateNum << ", \"bucket_inserts\": " << pass.insertNum
+        << ", \"bucket_removes\": " << pass.removeNum << ", \"cut_drift\": " << pass.cutDrift << ", \"init_gain_s\": " << pass.initGainTime
+        << ", \"move_s\": " << pass.moveTime << ", \"update_gain_s\": " << pass.updateGainTime
+        << ", \"rollback_s\": " << pass.rollbackTime << ", \"carry_gain_s\": " << pass.carryGainTime << "}";
+}
+
+void Profile::writeJson(ostream &out) const
+{
+    // sum the passes up for the totals
+    PassProfile total;
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        total.moveNum += _passes[i].moveNum;
+        total.keptNum += _passes[i].keptNum;
+        total.rollbackNum += _passes[i].rollbackNum;
+        total.gainUpdateNum += _passes[i].gainUpdateNum;
+        total.insertNum += _passes[i].insertNum;
+        total.removeNum += _passes[i].removeNum;
+        total.cutDrift += _passes[i].cutDrift;
+        total.initGainTime += _passes[i].initGainTime;
+        total.moveTime += _passes[i].moveTime;
+        total.updateGainTime += _passes[i].updateGainTime;
+        total.rollbackTime += _passes[i].rollbackTime;
+        total.carryGainTime += _passes[i].carryGainTime;
+    }
+
+    out << "{" << endl;
+    out << "  \"cutsize\": " << _cutSize << "," << endl;
+    out << "  \"peak_rss_kb\": " << _peakMemory << "," << endl;
+    out << "  \"phases\": {";
+    for (size_t i = 0; i < _phases.size(); ++i)
+    {
+        out << (i == 0 ? "" : ",") << endl
+            << "    \"" << _phases[i].first << "\": " << _phases[i].second;
+    }
+    out << endl << "  }," << endl;
+
+    out << "  \"total\": ";
+    writePass(out, total);
+    out << "," << endl;
+    out << "  \"passes\": [";
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        out << (i == 0 ? "" : ",") << endl << "    ";
+        writePass(out, _passes[i]);
+    }
+    out << endl << "  ]" << endl;
+    out << "}" << endl;
+    return;
+}
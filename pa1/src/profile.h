@@ -0,0 +1,57 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+// seconds elapsed since start on the monotonic clock
+inline double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// counters and timers of one F-M pass, always collected since they cost a few increments per move
+struct PassProfile
+{
+    PassProfile() :
+        moveNum(0), keptNum(0), rollbackNum(0), gainUpdateNum(0), insertNum(0), removeNum(0),
+        cutDrift(0), initGainTime(0), moveTime(0), updateGainTime(0), rollbackTime(0), carryGainTime(0) { }
+
+    int         moveNum;        // moves tried
+    int         keptNum;        // moves kept, the best prefix
+    int         rollbackNum;    // moves undone by the rollback
+    long long   gainUpdateNum;  // gain changes of free cells
+    long long   insertNum;      // bucket insertions (including the initial fill)
+    long long   removeNum;      // bucket removals
+    int         cutDrift;       // cut change of the nets left out of the gains, added to the cut after the rollback
+    double      initGainTime;   // seconds computing the gains and filling the buckets
+    double      moveTime;       // seconds picking and moving cells, updateGain included
+    double      updateGainTime; // seconds in updateGain, estimated from every 16th call
+    double      rollbackTime;   // seconds rolling back to the best prefix
+    double      carryGainTime;  // seconds patching the gains of the next pass around the kept cells
+};
+
+// run profile written as JSON: named phases of the whole run plus the passes of the final refinement
+class Profile
+{
+public:
+    Profile() : _cutSize(0), _peakMemory(0) { }
+
+    // modify methods
+    void addPhase(const string& name, double seconds)   { _phases.push_back(make_pair(name, seconds)); }
+    void setPasses(const vector<PassProfile>& passes)   { _passes = passes; }
+    void setResult(int cutSize, long peakMemory)        { _cutSize = cutSize; _peakMemory = peakMemory; }
+
+    void writeJson(ostream& out) const;
+
+private:
+    vector<pair<string, double> >   _phases;        // name and seconds of each phase in run order
+    vector<PassProfile>             _passes;        // passes of the final refinement
+    int                             _cutSize;       // final cut size
+    long                            _peakMemory;    // peak resident set size in KB
+};
+
+#endif  // PROFILE_H
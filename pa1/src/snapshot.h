@@ -0,0 +1,46 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+using namespace std;
+
+// binary snapshot of a parsed netlist, laid out as
+// header | hypergraph arrays | cell names | net names (names are NUL-terminated)
+const char      SNAPSHOT_MAGIC[8] = {'F', 'M', 'S', 'N', 'A', 'P', '\0', '\0'};
+const uint32_t  SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader
+{
+    char        magic[8];       // SNAPSHOT_MAGIC
+    uint32_t    version;        // SNAPSHOT_VERSION
+    uint32_t    headerSize;     // sizeof(SnapshotHeader), guards against layout changes
+    uint64_t    sourceSize;     // size of the text netlist the snapshot was built from
+    int64_t     sourceMtime;    // modification time of that netlist
+    double      bFactor;        // balance factor
+    int32_t     cellNum;        // number of cells
+    int32_t     netNum;         // number of nets
+    uint64_t    payloadSize;    // bytes following the header
+    uint64_t    checksum;       // checksum of the payload
+};
+
+// 64-bit FNV-1a over 8-byte words, the tail is folded in byte by byte
+inline uint64_t snapshotChecksum(const char* data, size_t size)
+{
+    uint64_t h = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; ++i)
+    {
+        h = (h ^ (unsigned char)data[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+#endif  // SNAPSHOT_H
@@ -0,0 +1,47 @@
+#include <string>
+#include <sstream>
+#include "stoppolicy.h"
+using namespace std;
+
+string FixedFractionStop::getName() const
+{
+    stringstream name;
+    name << "fixed (" << _firstFraction << " then " << _fraction << " of the cells per pass)";
+    return name.str();
+}
+
+void FixedFractionStop::startPass(int passId, int cellNum)
+{
+    _stopConstant = passId == 0 ? cellNum * _firstFraction : cellNum * _fraction;
+}
+
+bool FixedFractionStop::shouldStop(int moveNum, int /*accGain*/, int /*maxAccGain*/)
+{
+    return moveNum >= _stopConstant;
+}
+
+string AdaptiveStop::getName() const
+{
+    stringstream name;
+    name << "adaptive (distance " << _distance << ", window " << _window << ")";
+    return name.str();
+}
+
+void AdaptiveStop::startPass(int /*passId*/, int /*cellNum*/)
+{
+    _belowNum = 0;
+}
+
+bool AdaptiveStop::shouldStop(int /*moveNum*/, int accGain, int maxAccGain)
+{
+    // the window restarts whenever the gain climbs back within the distance
+    if (maxAccGain - accGain >= _distance)
+    {
+        ++_belowNum;
+    }
+    else
+    {
+        _belowNum = 0;
+    }
+    return _belowNum >= _window;
+}
@@ -0,0 +1,59 @@
+#ifndef STOPPOLICY_H
+#define STOPPOLICY_H
+
+#include <string>
+using namespace std;
+
+// decides when an F-M pass stops moving cells, a partitioner owns its own copy
+class StopPolicy
+{
+public:
+    virtual ~StopPolicy() { }
+
+    virtual StopPolicy* clone() const = 0;
+    virtual string getName() const = 0;
+
+    // called before the first move of pass passId (0-based) and before every further move
+    virtual void startPass(int passId, int cellNum) = 0;
+    virtual bool shouldStop(int moveNum, int accGain, int maxAccGain) = 0;
+};
+
+// stop after a fixed fraction of the cells has moved, half of them in the first pass and a fifth later on
+class FixedFractionStop : public StopPolicy
+{
+public:
+    FixedFractionStop(double firstFraction = 0.5, double fraction = 0.2) :
+        _firstFraction(firstFraction), _fraction(fraction), _stopConstant(0) { }
+
+    StopPolicy* clone() const   { return new FixedFractionStop(*this); }
+    string getName() const;
+
+    void startPass(int passId, int cellNum);
+    bool shouldStop(int moveNum, int accGain, int maxAccGain);
+
+private:
+    double  _firstFraction; // fraction of the cells moved in the first pass
+    double  _fraction;      // fraction of the cells moved in the later passes
+    int     _stopConstant;  // move number at which the current pass stops
+};
+
+// stop once the accumulated gain has stayed at least distance below its maximum for window moves
+class AdaptiveStop : public StopPolicy
+{
+public:
+    AdaptiveStop(int distance, int window) :
+        _distance(distance), _window(window), _belowNum(0) { }
+
+    StopPolicy* clone() const   { return new AdaptiveStop(*this); }
+    string getName() const;
+
+    void startPass(int passId, int cellNum);
+    bool shouldStop(int moveNum, int accGain, int maxAccGain);
+
+private:
+    int     _distance;      // gain distance below the maximum accumulated gain
+    int     _window;        // number of consecutive moves spent that far below the maximum
+    int     _belowNum;      // consecutive moves so far below the maximum in the current pass
+};
+
+#endif  // STOPPOLICY_H
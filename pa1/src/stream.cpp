@@ -0,0 +1,510 @@
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include "nametable.h"
+#include "stream.h"
+using namespace std;
+
+// bytes read from the netlist at a time
+const size_t STREAM_BUFFER_SIZE = 1 << 20;
+
+void StreamPartitioner::openInput()
+{
+    if (_inFile != NULL)
+    {
+        fclose(_inFile);
+    }
+    _inFile = fopen(_inFileName, "r");
+    if (_inFile == NULL)
+    {
+        cerr << "Cannot open the input file \"" << _inFileName
+             << "\". The program will be terminated..." << endl;
+        exit(1);
+    }
+    _buffer.resize(STREAM_BUFFER_SIZE);
+    _bufferPos = 0;
+    _bufferEnd = 0;
+}
+
+bool StreamPartitioner::nextToken()
+{
+    // a token may straddle two buffer fills, its pieces are appended until a separator shows up
+    _token.clear();
+    while (true)
+    {
+        if (_bufferPos == _bufferEnd)
+        {
+            _bufferEnd = fread(_buffer.data(), 1, _buffer.size(), _inFile);
+            _bufferPos = 0;
+            if (_bufferEnd == 0)
+            {
+                return !_token.empty();
+            }
+        }
+        const char *data = _buffer.data(), *cur = data + _bufferPos, *end = data + _bufferEnd;
+        if (_token.empty())
+        {
+            while (cur != end && (*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r' || *cur == '\v' || *cur == '\f'))
+            {
+                ++cur;
+            }
+        }
+        const char *tokenBegin = cur;
+        while (cur != end && !(*cur == ' ' || *cur == '\n' || *cur == '\t' || *cur == '\r' || *cur == '\v' || *cur == '\f'))
+        {
+            ++cur;
+        }
+        _token.append(tokenBegin, cur);
+        _bufferPos = cur - data;
+        if (cur != end && !_token.empty())
+        {
+            return true;
+        }
+    }
+}
+
+bool StreamPartitioner::readNet(vector<int> &pins, bool intern)
+{
+    // read the cells of the next NET record, interning new cells on the first pass
+    pins.clear();
+    while (this->nextToken() && _token != "NET")
+    {
+    }
+    if (_token != "NET" || !this->nextToken())
+    {
+        return false;
+    }
+    int prevCellId = -1;
+    while (this->nextToken() && _token != ";")
+    {
+        int cellId;
+        if (intern)
+        {
+            bool inserted = false;
+            cellId = _cellNames.intern(_token.data(), _token.data() + _token.size(), inserted);
+            if (inserted)
+            {
+                _cellPart.push_back(2);
+            }
+        }
+        else
+        {
+            cellId = _cellNames.find(_token.data(), _token.data() + _token.size());
+        }
+        // skip a cell repeated right after itself, as the parser does
+        if (cellId != prevCellId)
+        {
+            pins.push_back(cellId);
+            prevCellId = cellId;
+        }
+    }
+    return true;
+}
+
+void StreamPartitioner::assignNet(const vector<int> &pins)
+{
+    // LDG scoring on the hyperedge: a new cell follows the pins of the net already placed, damped by how full
+    // each side is, and |A - B| never exceeds b times the assigned cells, so the final split meets the balance
+    int count[2] = {0, 0};
+    for (size_t i = 0; i < pins.size(); ++i)
+    {
+        if (_cellPart[pins[i]] != 2)
+        {
+            count[(int)_cellPart[pins[i]]]++;
+        }
+    }
+    for (size_t i = 0; i < pins.size(); ++i)
+    {
+        int cellId = pins[i];
+        if (_cellPart[cellId] != 2)
+        {
+            continue;
+        }
+        int assignedNum = _partSize[0] + _partSize[1] + 1;
+        double capacity = (1 + _bFactor) / 2 * assignedNum, maxDiff = max(1.0, _bFactor * assignedNum);
+        bool feasible[2] = {_partSize[0] + 1 - _partSize[1] <= maxDiff, _partSize[1] + 1 - _partSize[0] <= maxDiff};
+        double score[2] = {count[0] * (1 - _partSize[0] / capacity), count[1] * (1 - _partSize[1] / capacity)};
+        bool part;
+        if (feasible[0] && feasible[1])
+        {
+            part = score[0] != score[1] ? score[1] > score[0] : _partSize[1] < _partSize[0];
+        }
+        else
+        {
+            part = feasible[1];
+        }
+        _cellPart[cellId] = part;
+        _partSize[part]++;
+        count[part]++;
+    }
+
+    // every pin of the net is placed for good, so its cut state is final
+    if (count[0] > 0 && count[1] > 0)
+    {
+        ++_cutSize;
+    }
+    _pinNum += pins.size();
+    ++_netNum;
+}
+
+int StreamPartitioner::computeGain(int localId) const
+{
+    // the nets outside the window are taken in their state at the start of the sweep, where they added _extGain to
+    // the gain of the cell, and that share changes sign once the cell has left its side of the sweep start
+    int cellId = _chunkCells[localId], part = _cellPart[cellId];
+    int gain = part == _sweepPart[cellId] ? _extGain[localId] : -_extGain[localId];
+    for (int i = _cellNetStart[localId]; i < _cellNetStart[localId + 1]; ++i)
+    {
+        int net = _cellNets[i];
+        if (_netPartCount[2 * net + part] == 1)
+        {
+            ++gain;
+        }
+        if (_netPartCount[2 * net + !part] == 0)
+        {
+            --gain;
+        }
+    }
+    return gain;
+}
+
+void StreamPartitioner::moveCell(int localId)
+{
+    int cellId = _chunkCells[localId], fromPart = _cellPart[cellId];
+    _cellPart[cellId] = !fromPart;
+    _partSize[fromPart]--;
+    _partSize[!fromPart]++;
+    for (int i = _cellNetStart[localId]; i < _cellNetStart[localId + 1]; ++i)
+    {
+        _netPartCount[2 * _cellNets[i] + fromPart]--;
+        _netPartCount[2 * _cellNets[i] + !fromPart]++;
+    }
+}
+
+void StreamPartitioner::countCut()
+{
+    // stream the netlist once for the cut of the current partition and the gain of every cell over all its nets
+    vector<int> pins;
+    _cutSize = 0;
+    _cellGain.assign(_cellNum, 0);
+    this->openInput();
+    this->nextToken();
+    while (this->readNet(pins, false))
+    {
+        int count[2] = {0, 0};
+        for (size_t i = 0; i < pins.size(); ++i)
+        {
+            count[(int)_cellPart[pins[i]]]++;
+        }
+        if (count[0] > 0 && count[1] > 0)
+        {
+            ++_cutSize;
+        }
+        for (size_t i = 0; i < pins.size(); ++i)
+        {
+            int part = _cellPart[pins[i]];
+            if (count[part] == 1)
+            {
+                _cellGain[pins[i]]++;
+            }
+            if (count[!part] == 0)
+            {
+                _cellGain[pins[i]]--;
+            }
+        }
+    }
+}
+
+void StreamPartitioner::repairBalance()
+{
+    // the assignment only bounds |A - B| by the cells seen so far, so check the bounds of the final cell count
+    // and, if one is broken, move the cells which lose the least off the heavy side
+    double lowerBound = (1 - _bFactor) / 2 * _cellNum, upperBound = (1 + _bFactor) / 2 * _cellNum;
+    int heavy = _partSize[1] > _partSize[0];
+    if (_partSize[heavy] <= upperBound && _partSize[!heavy] >= lowerBound)
+    {
+        return;
+    }
+    this->countCut();
+    vector<int> candidates;
+    for (int i = 0; i < _cellNum; ++i)
+    {
+        if (_cellPart[i] == heavy)
+        {
+            candidates.push_back(i);
+        }
+    }
+    sort(candidates.begin(), candidates.end(), [this](int a, int b)
+         { return _cellGain[a] != _cellGain[b] ? _cellGain[a] > _cellGain[b] : a < b; });
+    for (size_t i = 0; i < candidates.size() && (_partSize[heavy] > upperBound || _partSize[!heavy] < lowerBound); ++i)
+    {
+        if (_partSize[!heavy] + 1 > upperBound)
+        {
+            break;
+        }
+        _cellPart[candidates[i]] = !heavy;
+        _partSize[heavy]--;
+        _partSize[!heavy]++;
+    }
+    this->countCut();
+    if (_partSize[heavy] > upperBound || _partSize[!heavy] < lowerBound)
+    {
+        cerr << "No balanced bisection of " << _cellNum << " cells within the balance factor " << _bFactor << "." << endl;
+    }
+}
+
+void StreamPartitioner::refineChunk()
+{
+    // number the cells of the window and build its cell to net adjacency
+    int chunkNetNum = _netStart.size() - 1;
+    _chunkCells.clear();
+    for (size_t i = 0; i < _netPins.size(); ++i)
+    {
+        int cellId = _netPins[i];
+        if (_localId[cellId] == -1)
+        {
+            _localId[cellId] = _chunkCells.size();
+            _chunkCells.push_back(cellId);
+        }
+    }
+    int localNum = _chunkCells.size();
+    _cellNetStart.assign(localNum + 1, 0);
+    for (size_t i = 0; i < _netPins.size(); ++i)
+    {
+        ++_cellNetStart[_localId[_netPins[i]] + 1];
+    }
+    for (int i = 0; i < localNum; ++i)
+    {
+        _cellNetStart[i + 1] += _cellNetStart[i];
+    }
+    _cellNets.resize(_netPins.size());
+    _netPartCount.assign(2 * chunkNetNum, 0);
+    vector<int> fillPos(_cellNetStart.begin(), _cellNetStart.end() - 1);
+    for (int i = 0; i < chunkNetNum; ++i)
+    {
+        for (int j = _netStart[i]; j < _netStart[i + 1]; ++j)
+        {
+            _cellNets[fillPos[_localId[_netPins[j]]]++] = i;
+            _netPartCount[2 * i + _sweepPart[_netPins[j]]]++;
+        }
+    }
+
+    // the share of the outside nets in the gain of the sweep start is what the window nets leave of it
+    _extGain.resize(localNum);
+    for (int i = 0; i < localNum; ++i)
+    {
+        int part = _sweepPart[_chunkCells[i]];
+        _extGain[i] = _cellGain[_chunkCells[i]];
+        for (int j = _cellNetStart[i]; j < _cellNetStart[i + 1]; ++j)
+        {
+            if (_netPartCount[2 * _cellNets[j] + part] == 1)
+            {
+                _extGain[i]--;
+            }
+            if (_netPartCount[2 * _cellNets[j] + !part] == 0)
+            {
+                _extGain[i]++;
+            }
+        }
+    }
+    _netPartCount.assign(2 * chunkNetNum, 0);
+    for (int i = 0; i < chunkNetNum; ++i)
+    {
+        for (int j = _netStart[i]; j < _netStart[i + 1]; ++j)
+        {
+            _netPartCount[2 * i + _cellPart[_netPins[j]]]++;
+        }
+    }
+
+    // every cell may move, the gains are exact as long as no outside net changed since the sweep start
+    double lowerBound = (1 - _bFactor) / 2 * _cellNum, upperBound = (1 + _bFactor) / 2 * _cellNum;
+    vector<char> cellLock(localNum, false);
+    vector<int> moveStack;
+    for (int pass = 0; pass < _maxPassNum; ++pass)
+    {
+        priority_queue<pair<int, int> > frontier;
+        for (int i = 0; i < localNum; ++i)
+        {
+            frontier.push(make_pair(this->computeGain(i), -i));
+        }
+        int accGain = 0, bestGain = 0, bestMoveNum = 0;
+        moveStack.clear();
+        while (!frontier.empty())
+        {
+            int localId = -frontier.top().second, gain = frontier.top().first;
+            frontier.pop();
+            if (cellLock[localId])
+            {
+                continue;
+            }
+            int currentGain = this->computeGain(localId);
+            if (currentGain != gain)
+            {
+                frontier.push(make_pair(currentGain, -localId));
+                continue;
+            }
+            int part = _cellPart[_chunkCells[localId]];
+            if (_partSize[part] - 1 < lowerBound || _partSize[!part] + 1 > upperBound)
+            {
+                continue;
+            }
+
+            this->moveCell(localId);
+            cellLock[localId] = true;
+            moveStack.push_back(localId);
+            accGain += gain;
+            if (accGain > bestGain)
+            {
+                bestGain = accGain;
+                bestMoveNum = moveStack.size();
+            }
+            else if ((int)moveStack.size() - bestMoveNum >= _searchWindow)
+            {
+                break;
+            }
+            for (int i = _cellNetStart[localId]; i < _cellNetStart[localId + 1]; ++i)
+            {
+                int net = _cellNets[i];
+                if (_netStart[net + 1] - _netStart[net] > _largeNetSize)
+                {
+                    continue;
+                }
+                for (int j = _netStart[net]; j < _netStart[net + 1]; ++j)
+                {
+                    int neighbor = _localId[_netPins[j]];
+                    if (!cellLock[neighbor])
+                    {
+                        frontier.push(make_pair(this->computeGain(neighbor), -neighbor));
+                    }
+                }
+            }
+        }
+
+        // back to the best prefix
+        for (int i = moveStack.size() - 1; i >= bestMoveNum; --i)
+        {
+            this->moveCell(moveStack[i]);
+        }
+        for (size_t i = 0; i < moveStack.size(); ++i)
+        {
+            cellLock[moveStack[i]] = false;
+        }
+        _moveNum += bestMoveNum;
+        if (bestGain <= 0)
+        {
+            break;
+        }
+    }
+
+    for (int i = 0; i < localNum; ++i)
+    {
+        _localId[_chunkCells[i]] = -1;
+    }
+}
+
+void StreamPartitioner::partition()
+{
+    // first pass: assign every cell the first time it shows up
+    vector<int> pins;
+    this->openInput();
+    if (this->nextToken())
+    {
+        _bFactor = strtod(_token.c_str(), NULL);
+    }
+    while (this->readNet(pins, true))
+    {
+        this->assignNet(pins);
+    }
+    _cellNum = _cellNames.getNameNum();
+    this->repairBalance();
+    cout << "Streaming assignment: " << _cellNum << " cells, " << _netNum << " nets, " << _pinNum << " pins, cutsize " << _cutSize << endl;
+
+    // then sweeps over windows of consecutive nets, a sweep streams the netlist twice: once for the exact cut and
+    // the gains, once for the windows; a window only sees its own nets up to date, so moves made by other windows
+    // may spoil its gains, and a sweep which does not lower the exact cut is undone
+    if (_windowNetNum > 0)
+    {
+        _localId.assign(_cellNum, -1);
+        this->countCut();
+        while (_sweepNum < _maxSweepNum)
+        {
+            int cutSize = _cutSize, partSize[2] = {_partSize[0], _partSize[1]}, moveNum = _moveNum;
+            _sweepPart = _cellPart;
+            ++_sweepNum;
+            this->openInput();
+            this->nextToken();
+            bool more = true;
+            while (more)
+            {
+                _netStart.assign(1, 0);
+                _netPins.clear();
+                while ((int)_netStart.size() <= _windowNetNum && (more = this->readNet(pins, false)))
+                {
+                    _netPins.insert(_netPins.end(), pins.begin(), pins.end());
+                    _netStart.push_back(_netPins.size());
+                }
+                if (_netStart.size() > 1)
+                {
+                    this->refineChunk();
+                    ++_chunkNum;
+                }
+            }
+            if (_moveNum == moveNum)
+            {
+                break;
+            }
+            this->countCut();
+            if (_cutSize >= cutSize)
+            {
+                _cellPart.swap(_sweepPart);
+                _partSize[0] = partSize[0];
+                _partSize[1] = partSize[1];
+                _cutSize = cutSize;
+                _moveNum = moveNum;
+                ++_undoneSweepNum;
+                break;
+            }
+        }
+        cout << "Window F-M: " << _moveNum << " moves in " << _chunkNum << " windows of " << _windowNetNum << " nets over " << _sweepNum
+             << " sweeps (" << _undoneSweepNum << " undone)" << endl;
+    }
+    fclose(_inFile);
+    _inFile = NULL;
+}
+
+void StreamPartitioner::printSummary() const
+{
+    cout << endl;
+    cout << "==================== Summary ====================" << endl;
+    cout << " Cutsize: " << _cutSize << endl;
+    cout << " Total cell number: " << _cellNum << endl;
+    cout << " Total net number:  " << _netNum << endl;
+    cout << " Cell Number of partition A: " << _partSize[0] << endl;
+    cout << " Cell Number of partition B: " << _partSize[1] << endl;
+    cout << "=================================================" << endl;
+    cout << endl;
+    return;
+}
+
+void StreamPartitioner::writeResult(fstream &outFile)
+{
+    outFile << "Cutsize = " << _cutSize << '\n';
+    for (int part = 0; part < 2; ++part)
+    {
+        outFile << "G" << part + 1 << " " << _partSize[part] << '\n';
+        for (int i = 0; i < _cellNum; ++i)
+        {
+            if (_cellPart[i] == part)
+            {
+                outFile << _cellNames.getName(i) << " ";
+            }
+        }
+        outFile << ";\n";
+    }
+    return;
+}
@@ -0,0 +1,98 @@
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "nametable.h"
+using namespace std;
+
+// one-pass streaming bisection for netlists whose pins do not fit in memory, cells are assigned on first sight
+// and only per-cell state is kept, optional sweeps refine windows of nets with F-M
+class StreamPartitioner
+{
+public:
+    // constructor and destructor
+    StreamPartitioner(const char* inFileName) :
+        _inFileName(inFileName), _bFactor(0), _windowNetNum(0), _maxPassNum(4), _maxSweepNum(4), _largeNetSize(50), _searchWindow(100),
+        _cellNum(0), _netNum(0), _pinNum(0), _cutSize(0), _moveNum(0), _chunkNum(0), _sweepNum(0), _undoneSweepNum(0),
+        _inFile(NULL), _bufferPos(0), _bufferEnd(0) {
+        _partSize[0] = 0;
+        _partSize[1] = 0;
+    }
+    ~StreamPartitioner() { }
+
+    // basic access methods
+    int getCutSize() const          { return _cutSize; }
+    int getCellNum() const          { return _cellNum; }
+    int getNetNum() const           { return _netNum; }
+    int getPartSize(int part) const { return _partSize[part]; }
+    int getMoveNum() const          { return _moveNum; }
+    int getChunkNum() const         { return _chunkNum; }
+    int getSweepNum() const         { return _sweepNum; }
+
+    // set functions
+    // nets per refinement window, 0 for the streaming assignment only
+    void setWindowNetNum(const int windowNetNum)    { _windowNetNum = windowNetNum; }
+
+    // modify method
+    void partition();
+
+    // member functions about reporting
+    void printSummary() const;
+    void writeResult(fstream& outFile);
+
+private:
+    const char*         _inFileName;    // netlist, read once per pass
+    double              _bFactor;       // the balance factor to be met
+    int                 _windowNetNum;  // nets per refinement window, 0 for no refinement
+    int                 _maxPassNum;    // upper bound of the F-M passes of a window
+    int                 _maxSweepNum;   // upper bound of the sweeps over the windows
+    int                 _largeNetSize;  // a pass does not queue the pins of nets larger than this
+    int                 _searchWindow;  // a pass stops after this many moves without a new best prefix
+    int                 _cellNum;       // number of cells
+    int                 _netNum;        // number of nets
+    long long           _pinNum;        // number of pins
+    int                 _cutSize;       // cut size
+    int                 _partSize[2];   // size of partition A(0) and B(1)
+    int                 _moveNum;       // number of kept refinement moves
+    int                 _chunkNum;      // number of refined windows
+    int                 _sweepNum;      // number of sweeps run
+    int                 _undoneSweepNum;    // number of sweeps undone for not lowering the cut
+
+    // per-cell state, the only state which grows with the netlist
+    NameTable           _cellNames;     // interned cell names, id of a name is the cell id
+    vector<char>        _cellPart;      // partition of each cell (0-A, 1-B, 2 until its first net is assigned)
+    vector<char>        _sweepPart;     // partition of each cell at the start of the sweep
+    vector<int>         _cellGain;      // gain of each cell over all its nets at the start of the sweep
+
+    // window state, the per-cell array is reset through _chunkCells so a window costs only its pins
+    vector<int>         _localId;       // id of each cell inside the window, -1 outside
+    vector<int>         _chunkCells;    // cells of the window by local id
+    vector<int>         _netStart;      // first pin of each window net, CSR
+    vector<int>         _netPins;       // cells of the window nets
+    vector<int>         _cellNetStart;  // first net of each window cell, CSR
+    vector<int>         _cellNets;      // window nets of each window cell
+    vector<int>         _netPartCount;  // cell number of each window net in A(2 * id) and B(2 * id + 1)
+    vector<int>         _extGain;       // share of the nets outside the window in the sweep start gain of each window cell
+
+    // input stream
+    FILE*               _inFile;        // netlist being read
+    vector<char>        _buffer;        // read buffer
+    size_t              _bufferPos;     // next unread byte of the buffer
+    size_t              _bufferEnd;     // end of the valid bytes of the buffer
+    string              _token;         // last token read
+
+    void openInput();
+    bool nextToken();
+    bool readNet(vector<int>& pins, bool intern);
+    void assignNet(const vector<int>& pins);
+    int computeGain(int localId) const;
+    void moveCell(int localId);
+    void countCut();
+    void repairBalance();
+    void refineChunk();
+};
+
+#endif  // STREAM_H
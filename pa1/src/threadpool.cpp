@@ -0,0 +1,78 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include "threadpool.h"
+using namespace std;
+
+ThreadPool::ThreadPool(int threadNum) :
+    _pendingNum(0), _stop(false)
+{
+    if (threadNum <= 0)
+    {
+        threadNum = thread::hardware_concurrency() > 0 ? thread::hardware_concurrency() : 1;
+    }
+    for (int i = 0; i < threadNum; ++i)
+    {
+        _workers.push_back(thread(&ThreadPool::workerLoop, this));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stop = true;
+    }
+    _taskCond.notify_all();
+    for (size_t i = 0; i < _workers.size(); ++i)
+    {
+        _workers[i].join();
+    }
+}
+
+void ThreadPool::submit(const function<void()> &task)
+{
+    {
+        lock_guard<mutex> lock(_mutex);
+        _tasks.push_back(task);
+        ++_pendingNum;
+    }
+    _taskCond.notify_one();
+}
+
+void ThreadPool::wait()
+{
+    // block until every submitted task has finished
+    unique_lock<mutex> lock(_mutex);
+    _doneCond.wait(lock, [this]
+                   { return _pendingNum == 0; });
+}
+
+void ThreadPool::workerLoop()
+{
+    while (true)
+    {
+        function<void()> task;
+        {
+            unique_lock<mutex> lock(_mutex);
+            _taskCond.wait(lock, [this]
+                           { return _stop || !_tasks.empty(); });
+            if (_tasks.empty())
+            {
+                return;
+            }
+            task = _tasks.front();
+            _tasks.pop_front();
+        }
+        task();
+        {
+            lock_guard<mutex> lock(_mutex);
+            if (--_pendingNum == 0)
+            {
+                _doneCond.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+using namespace std;
+
+class ThreadPool
+{
+public:
+    // constructor and destructor, threadNum <= 0 means one worker per hardware thread
+    ThreadPool(int threadNum);
+    ~ThreadPool();
+
+    // basic access methods
+    int getThreadNum() const    { return (int)_workers.size(); }
+
+    // modify methods, a running task may submit further tasks before it returns
+    void submit(const function<void()>& task);
+    void wait();
+
+private:
+    vector<thread>              _workers;       // worker threads
+    deque<function<void()> >    _tasks;         // tasks waiting for a worker
+    mutex                       _mutex;         // guards _tasks, _pendingNum and _stop
+    condition_variable          _taskCond;      // signaled when a task is queued or the pool stops
+    condition_variable          _doneCond;      // signaled when the last pending task finishes
+    int                         _pendingNum;    // number of queued or running tasks
+    bool                        _stop;          // whether the workers should exit
+
+    void workerLoop();
+};
+
+#endif  // THREADPOOL_H